@@ -4,6 +4,7 @@
 #include <cmath>
 #include <numbers>
 #include <array>
+#include <algorithm>
 
 class BinormalDistribution
 {
@@ -36,6 +37,13 @@ public:
         return exp((pow(m_sy,2)*pow(m_ux - x,2) - 2*m_r*m_sx*m_sy*(m_ux - x)*(m_uy - y) + pow(m_sx,2)*pow(m_uy - y,2)) / (2*(pow(m_r,2)-1)*pow(m_sx,2)*pow(m_sy,2))) / (2*sqrt(1.0 - pow(m_r,2))*m_sx*m_sy*std::numbers::pi_v<double>);
     }
 
+    // coefficients c such that logPdf(x, y) == c[0] + c[1]*dx*dx + c[2]*dx*dy + c[3]*dy*dy with dx = x - meanX(), dy = y - meanY()
+    std::array<double, 4> logPdfCoefficients() const
+    {
+        double d = 2*(pow(m_r,2) - 1)*pow(m_sx,2)*pow(m_sy,2);
+        return {-log(2*sqrt(1.0 - pow(m_r,2))*m_sx*m_sy*std::numbers::pi_v<double>), pow(m_sy,2)/d, -2*m_r*m_sx*m_sy/d, pow(m_sx,2)/d};
+    }
+
     std::array<double, 4> covMat() const
     {
         double r = m_sx * m_sy * m_r;
@@ -63,4 +71,55 @@ private:
     double m_r {0};
 };
 
+// weighted sums of first and second moments of 2d points, taken relative to an origin close to the points to limit
+// cancellation. Moments with the same origin can be summed, so a fit can be reduced in parallel over blocks of points.
+
+class BinormalMoments
+{
+public:
+
+    BinormalMoments(double originX = 0, double originY = 0) : m_ox(originX), m_oy(originY) {}
+
+    void add(double x, double y, double w)
+    {
+        x -= m_ox;
+        y -= m_oy;
+        m_w += w;
+        m_x += w * x;
+        m_y += w * y;
+        m_xx += w * x * x;
+        m_yy += w * y * y;
+        m_xy += w * x * y;
+    }
+
+    BinormalMoments & operator+=(const BinormalMoments & other)
+    {
+        m_w += other.m_w;
+        m_x += other.m_x;
+        m_y += other.m_y;
+        m_xx += other.m_xx;
+        m_yy += other.m_yy;
+        m_xy += other.m_xy;
+        return *this;
+    }
+
+    double weight() const {return m_w;}
+    double meanX() const {return m_w > 0 ? m_ox + m_x / m_w : 0;}
+    double meanY() const {return m_w > 0 ? m_oy + m_y / m_w : 0;}
+    double varianceX() const {return m_w > 0 ? std::max(0.0, m_xx / m_w - pow(m_x / m_w, 2)) : 0;}
+    double varianceY() const {return m_w > 0 ? std::max(0.0, m_yy / m_w - pow(m_y / m_w, 2)) : 0;}
+    double covariance() const {return m_w > 0 ? m_xy / m_w - (m_x / m_w) * (m_y / m_w) : 0;}
+
+private:
+
+    double m_ox;
+    double m_oy;
+    double m_w {0};
+    double m_x {0};
+    double m_y {0};
+    double m_xx {0};
+    double m_yy {0};
+    double m_xy {0};
+};
+
 #endif // FUZZYDROPLETS_CORE_BINORMAL_H
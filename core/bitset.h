@@ -0,0 +1,169 @@
+#ifndef FUZZY_DROPLETS_BITSET_H
+#define FUZZY_DROPLETS_BITSET_H
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+
+// A fixed number of flags, e.g. one per droplet, packed 64 to a word so that counting them, finding the next one set
+// and walking runs of them go a word at a time. Bits past size() in the last word are always clear.
+// Unlike std::vector<bool> two threads may set bits sharing a word, through setAtomic() and setRange().
+
+class BitSet
+{
+public:
+
+    using Word = std::uint64_t;
+    static const size_t WordBits = 64;
+
+    BitSet() {}
+    explicit BitSet(size_t size, bool value = false) {resize(size, value);}
+
+    size_t size() const {return m_size;}
+    bool empty() const {return m_size == 0;}
+    const std::vector<Word> & words() const {return m_words;}
+
+    // new bits take value
+    void resize(size_t size, bool value = false)
+    {
+        if (value && m_size % WordBits != 0)
+            m_words.back() |= ~Word(0) << (m_size % WordBits);
+        m_words.resize((size + WordBits - 1) / WordBits, value ? ~Word(0) : 0);
+        m_size = size;
+        clearTail();
+    }
+
+    bool test(size_t i) const {assert(i < m_size); return m_words[i / WordBits] & bit(i);}
+    bool operator[](size_t i) const {return test(i);}
+
+    void set(size_t i, bool value = true)
+    {
+        assert(i < m_size);
+        if (value)
+            m_words[i / WordBits] |= bit(i);
+        else
+            m_words[i / WordBits] &= ~bit(i);
+    }
+    void reset(size_t i) {set(i, false);}
+
+    // safe against other threads setting bits in the same word
+    void setAtomic(size_t i, bool value = true)
+    {
+        assert(i < m_size);
+        std::atomic_ref word(m_words[i / WordBits]);
+        if (value)
+            word.fetch_or(bit(i), std::memory_order_relaxed);
+        else
+            word.fetch_and(~bit(i), std::memory_order_relaxed);
+    }
+
+    // sets [begin, end), whole words plainly and the partial words at either end atomically, so threads may fill
+    // disjoint ranges at once
+    void setRange(size_t begin, size_t end, bool value = true)
+    {
+        assert(begin <= end && end <= m_size);
+        if (begin >= end) return;
+        size_t first = begin / WordBits;
+        size_t last = (end - 1) / WordBits;
+        Word head = ~Word(0) << (begin % WordBits);
+        Word tail = ~Word(0) >> (WordBits - 1 - (end - 1) % WordBits);
+        if (first == last) {
+            setMasked(first, head & tail, value);
+        } else {
+            setMasked(first, head, value);
+            std::fill(m_words.begin() + first + 1, m_words.begin() + last, value ? ~Word(0) : 0);
+            setMasked(last, tail, value);
+        }
+    }
+
+    void fill(bool value)
+    {
+        std::fill(m_words.begin(), m_words.end(), value ? ~Word(0) : 0);
+        clearTail();
+    }
+
+    size_t count() const
+    {
+        size_t result = 0;
+        for (auto w : m_words)
+            result += std::popcount(w);
+        return result;
+    }
+
+    bool any() const {return std::any_of(m_words.begin(), m_words.end(), [](Word w) {return w != 0;});}
+    bool none() const {return !any();}
+
+    // the first set bit at or after i, or size() if there is none
+    size_t findNext(size_t i) const {return find(i, 0);}
+    // the first clear bit at or after i, or size() if there is none
+    size_t findNextClear(size_t i) const {return find(i, ~Word(0));}
+
+    // calls f(i) for each set bit in increasing order
+    template <typename F>
+    void forEach(F && f) const
+    {
+        for (size_t w = 0; w < m_words.size(); ++w) {
+            for (Word word = m_words[w]; word != 0; word &= word - 1)
+                f(w * WordBits + std::countr_zero(word));
+        }
+    }
+
+    // calls f(begin, end) for each maximal run [begin, end) of set bits in increasing order
+    template <typename F>
+    void forEachRun(F && f) const
+    {
+        for (size_t begin = findNext(0); begin < m_size; ) {
+            size_t end = findNextClear(begin);
+            f(begin, end);
+            begin = findNext(end);
+        }
+    }
+
+    std::vector<size_t> indices() const
+    {
+        std::vector<size_t> result;
+        result.reserve(count());
+        forEach([&](size_t i) {result.push_back(i);});
+        return result;
+    }
+
+private:
+
+    static Word bit(size_t i) {return Word(1) << (i % WordBits);}
+
+    void setMasked(size_t w, Word mask, bool value)
+    {
+        std::atomic_ref word(m_words[w]);
+        if (value)
+            word.fetch_or(mask, std::memory_order_relaxed);
+        else
+            word.fetch_and(~mask, std::memory_order_relaxed);
+    }
+
+    void clearTail()
+    {
+        if (m_size % WordBits != 0)
+            m_words.back() &= ~(~Word(0) << (m_size % WordBits));
+    }
+
+    // words are xor'ed with flip so the bits looked for are the set ones
+    size_t find(size_t i, Word flip) const
+    {
+        if (i >= m_size) return m_size;
+        size_t w = i / WordBits;
+        Word word = (m_words[w] ^ flip) & (~Word(0) << (i % WordBits));
+        while (word == 0) {
+            if (++w == m_words.size()) return m_size;
+            word = m_words[w] ^ flip;
+        }
+        return std::min(m_size, w * WordBits + std::countr_zero(word));
+    }
+
+    std::vector<Word> m_words;
+    size_t m_size {0};
+};
+
+#endif // FUZZY_DROPLETS_BITSET_H
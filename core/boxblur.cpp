@@ -0,0 +1,150 @@
+#include "boxblur.h"
+#include "data.h"
+#include <QtGlobal>
+#include <atomic>
+#include <execution>
+#include <numeric>
+#include <ranges>
+
+#ifdef Q_OS_MACOS
+#include <QtConcurrent>
+#endif
+
+BoxBlur::BoxBlur(const Data * data, const std::vector<size_t> & indices, double radius)
+    : m_data(data),
+    m_indices(indices),
+    m_radius(radius),
+    m_componentCount(data->colorComponentCount()),
+    m_stride(m_componentCount + 1),
+    m_grid(data, m_indices, radius / CellsPerRadius, MaxSums / m_stride)
+{
+    m_rowSums.assign(m_grid.rowCount() * (m_grid.columnCount() + 1) * m_stride, 0);
+
+#ifndef Q_OS_MACOS
+    auto rows = std::ranges::views::iota((size_t)0, m_grid.rowCount());
+    std::for_each(std::execution::par, rows.begin(), rows.end(), [&](size_t r) {
+#else
+    QList<size_t> rows(m_grid.rowCount(), 0);
+    std::iota(rows.begin(), rows.end(), 0);
+    QtConcurrent::blockingMap(rows.begin(), rows.end(), [&](const size_t & r) {
+#endif
+        for (size_t c = 0; c < m_grid.columnCount(); ++c) {
+            double * sums = rowSums(r, c + 1);
+            for (const auto & entry : m_grid.cell(c, r)) {
+                const auto & color = m_data->fuzzyColor(m_indices[entry.position]);
+                for (size_t k = 0; k < m_componentCount; ++k)
+                    sums[k] += std::max(0.0, color.weight(k));
+                sums[m_componentCount] += 1;
+            }
+            const double * previous = rowSums(r, c);
+            for (size_t k = 0; k < m_stride; ++k)
+                sums[k] += previous[k];
+        }
+    });
+}
+
+// every row of cells the circle reaches adds the span of cells wholly inside it from the running sums, then tests
+// the droplets of the cells at either end of that span
+void BoxBlur::blur(const DropletGrid::Entry & entry, std::vector<double> & sums) const
+{
+    std::ranges::fill(sums, 0);
+    const double w = m_radius;
+    const double w2 = w * w;
+    const auto & p = entry.point;
+    const long long lastColumn = m_grid.columnCount() - 1;
+    long long firstRow = std::max(0ll, m_grid.row(p.y() - w));
+    long long lastRow = std::min((long long)m_grid.rowCount() - 1, m_grid.row(p.y() + w));
+
+    auto addCell = [&](long long c, long long r) {
+        for (const auto & other : m_grid.cell(c, r)) {
+            double dx = other.point.x() - p.x();
+            double dy = other.point.y() - p.y();
+            if (dx * dx + dy * dy < w2) {
+                const auto & color = m_data->fuzzyColor(m_indices[other.position]);
+                for (size_t k = 0; k < m_componentCount; ++k)
+                    sums[k] += std::max(0.0, color.weight(k));
+                sums[m_componentCount] += 1;
+            }
+        }
+    };
+
+    for (long long r = firstRow; r <= lastRow; ++r) {
+        double y0 = m_grid.bottom(r);
+        double y1 = m_grid.bottom(r + 1);
+        double nearY = p.y() < y0 ? y0 - p.y() : (p.y() > y1 ? p.y() - y1 : 0);
+        double farY = std::max(p.y() - y0, y1 - p.y());
+        if (nearY >= w) continue;
+
+        double reach = std::sqrt(w2 - nearY * nearY);
+        long long c0 = std::max(0ll, m_grid.column(p.x() - reach));
+        long long c1 = std::min(lastColumn, m_grid.column(p.x() + reach));
+        if (c0 > c1) continue;
+
+        // cells whose far corners are strictly within the radius
+        long long f0 = c1 + 1;
+        long long f1 = c1;
+        if (farY < w) {
+            double inner = std::sqrt(w2 - farY * farY);
+            f0 = std::max(c0, m_grid.column(p.x() - inner) + 1);
+            f1 = std::min(c1, (long long)std::ceil((p.x() + inner - m_grid.left(0)) / m_grid.cellSize()) - 2);
+        }
+        if (f0 <= f1) {
+            const double * begin = rowSums(r, f0);
+            const double * end = rowSums(r, f1 + 1);
+            for (size_t k = 0; k < m_stride; ++k)
+                sums[k] += end[k] - begin[k];
+            for (long long c = c0; c < f0; ++c)
+                addCell(c, r);
+            for (long long c = f1 + 1; c <= c1; ++c)
+                addCell(c, r);
+        } else {
+            for (long long c = c0; c <= c1; ++c)
+                addCell(c, r);
+        }
+    }
+}
+
+std::vector<FuzzyColor> BoxBlur::run(const std::function<void(int)> & progress, const std::atomic<bool> * cancelled) const
+{
+    std::vector<FuzzyColor> colors(m_indices.size());
+    if (m_grid.rowCount() == 0) {
+        for (size_t i = 0; i < m_indices.size(); ++i)
+            colors[i] = m_data->fuzzyColor(m_indices[i]);
+        return colors;
+    }
+    std::atomic<size_t> done = 0;
+    std::atomic<int> percent = 0;
+
+    // a row of cells at a time, so neighbouring droplets share the cells they read
+#ifndef Q_OS_MACOS
+    auto rows = std::ranges::views::iota((size_t)0, m_grid.rowCount());
+    std::for_each(std::execution::par, rows.begin(), rows.end(), [&](size_t r) {
+#else
+    QList<size_t> rows(m_grid.rowCount(), 0);
+    std::iota(rows.begin(), rows.end(), 0);
+    QtConcurrent::blockingMap(rows.begin(), rows.end(), [&](const size_t & r) {
+#endif
+        if (cancelled && *cancelled) return;
+        std::vector<double> sums(m_stride);
+        auto entries = m_grid.cells(r);
+        for (const auto & entry : entries) {
+            blur(entry, sums);
+            if (sums[m_componentCount] == 0) {
+                colors[entry.position] = m_data->fuzzyColor(m_indices[entry.position]);
+            } else {
+                colors[entry.position] = FuzzyColor(std::vector<double>(sums.begin(), sums.begin() + m_componentCount));
+                colors[entry.position].normalize();
+            }
+        }
+
+        int newPercent = int(100 * (done += entries.size()) / m_indices.size());
+        int oldPercent = percent;
+        while (newPercent > oldPercent && !percent.compare_exchange_weak(oldPercent, newPercent)) {}
+        if (progress && newPercent > oldPercent)
+            progress(newPercent);
+    });
+
+    if (cancelled && *cancelled)
+        return std::vector<FuzzyColor>();
+    return colors;
+}
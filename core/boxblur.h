@@ -0,0 +1,44 @@
+#ifndef FUZZYDROPLETS_CORE_BOXBLUR_H
+#define FUZZYDROPLETS_CORE_BOXBLUR_H
+
+#include "dropletgrid.h"
+#include "fuzzycolor.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+class Data;
+
+// replaces the colour of each droplet with the normalized sum of the (non-negative) colours of the droplets within
+// radius of it, among the given droplets. The weights are binned into a grid of cells a fraction of the radius wide
+// with running sums along each row of cells, so the cells lying wholly inside a droplet's circle cost one lookup per
+// row and only the droplets of cells crossed by its edge are tested one by one.
+class BoxBlur
+{
+public:
+
+    BoxBlur(const Data * data, const std::vector<size_t> & indices, double radius);
+
+    // the new colours in the order of indices, or none once cancelled is set. Progress is given percentages from
+    // the worker threads.
+    std::vector<FuzzyColor> run(const std::function<void(int)> & progress = nullptr, const std::atomic<bool> * cancelled = nullptr) const;
+
+private:
+
+    static const int CellsPerRadius = 8;
+    static const size_t MaxSums = 1 << 23;     // bounds the memory of the running sums
+
+    const double * rowSums(size_t row, size_t column) const {return m_rowSums.data() + (row * (m_grid.columnCount() + 1) + column) * m_stride;}
+    double * rowSums(size_t row, size_t column) {return m_rowSums.data() + (row * (m_grid.columnCount() + 1) + column) * m_stride;}
+    void blur(const DropletGrid::Entry & entry, std::vector<double> & sums) const;
+
+    const Data * m_data;
+    std::vector<size_t> m_indices;
+    double m_radius;
+    size_t m_componentCount;
+    size_t m_stride;                    // the weights of each component then the droplet count
+    DropletGrid m_grid;
+    std::vector<double> m_rowSums;      // per row, the sums over the cells left of each column
+};
+
+#endif // FUZZYDROPLETS_CORE_BOXBLUR_H
@@ -50,13 +50,11 @@ struct CentroidsFromDesign
 
         if (result.size() > k) {
             std::vector<double> count(result.size(), 0.0);
-            for (size_t i = 0; i < data->points().size(); ++i) {
-                if (data->isSelected(i)) {
-                    for (size_t k = 0; k < data->colorComponentCount(); ++k) {
-                        count[k] += data->fuzzyColor(i).weight(k);
-                    }
+            data->selectionFilter().forEach([&](size_t i) {
+                for (size_t k = 0; k < data->colorComponentCount(); ++k) {
+                    count[k] += data->fuzzyColor(i).weight(k);
                 }
-            }
+            });
             std::vector<std::tuple<int,  double>> toSort;
 #ifdef Q_OS_LINUX
             toSort.reserve(count.size());
@@ -88,13 +86,11 @@ struct CentroidsFromCurrentColors
     static std::vector<Point> generate(const Data * data, int k)
     {
         std::vector<WeightedArithmeticMean<Point>> means (data->colorComponentCount());
-        for (size_t i = 0; i < data->points().size(); ++i) {
-            if (data->isSelected(i)) {
-                for (size_t k = 0; k < data->colorComponentCount(); ++k) {
-                    means[k].add(data->point(i), data->fuzzyColor(i).weight(k));
-                }
+        data->selectionFilter().forEach([&](size_t i) {
+            for (size_t k = 0; k < data->colorComponentCount(); ++k) {
+                means[k].add(data->point(i), data->fuzzyColor(i).weight(k));
             }
-        }
+        });
 #ifdef Q_OS_LINUX
         std::vector<std::tuple<size_t, WeightedArithmeticMean<Point>>> zip;
         for (size_t i = 0; i < means.size(); ++i) {
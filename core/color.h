@@ -5,6 +5,7 @@
 #include <cmath>
 #include <ranges>
 #include <array>
+#include <vector>
 #include <cassert>
 #include <QtGlobal>
 #include <QtDebug>
@@ -97,6 +98,47 @@ template <std::ranges::range ColorContainer, std::ranges::range WeightsContainer
     return rgba(int(std::round(sqrt(mixed[0]))), int(std::round(sqrt(mixed[1]))), int(std::round(sqrt(mixed[2]))), int(std::round(mixed[3])));
 }
 
+// additiveMixture over a fixed palette, the squared channels are computed once when the palette is set so mixing
+// is a multiply-add per channel and component. A weight of exactly 1 returns the palette colour without mixing.
+class AdditiveMixer
+{
+public:
+
+    AdditiveMixer() {}
+
+    template <std::ranges::range ColorContainer>
+    explicit AdditiveMixer(const ColorContainer & colors)
+        requires std::is_same_v<Rgba, std::ranges::range_value_t<ColorContainer>>
+    {
+        for (auto color : colors) {
+            m_colors.push_back(color);
+            m_squares.push_back({double(red(color) * red(color)), double(green(color) * green(color)), double(blue(color) * blue(color)), double(alpha(color))});
+        }
+    }
+
+    size_t size() const {return m_colors.size();}
+    const std::vector<Rgba> & colors() const {return m_colors;}
+
+    template <std::ranges::range WeightsContainer>
+    Rgba operator()(const WeightsContainer & weights) const
+        requires std::floating_point<std::ranges::range_value_t<WeightsContainer>>
+    {
+        assert(std::size(weights) == m_squares.size());
+        std::array<double, 4> mixed {0,0,0,0};
+        for (size_t i = 0; i < m_squares.size(); ++i) {
+            if (weights[i] == 1) return m_colors[i];
+            for (size_t c = 0; c < 4; ++c)
+                mixed[c] += m_squares[i][c] * weights[i];
+        }
+        return rgba(int(std::round(std::sqrt(mixed[0]))), int(std::round(std::sqrt(mixed[1]))), int(std::round(std::sqrt(mixed[2]))), int(std::round(mixed[3])));
+    }
+
+private:
+
+    std::vector<Rgba> m_colors;
+    std::vector<std::array<double, 4>> m_squares;
+};
+
 // given two colors, returns their alpha blended color
 [[maybe_unused]] static  Rgba alphaBlend(Rgba lower, Rgba upper)
 {
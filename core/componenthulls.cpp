@@ -0,0 +1,146 @@
+#include "componenthulls.h"
+#include "data.h"
+#include "bitset.h"
+#include <QThread>
+#include <QtGlobal>
+#include <execution>
+#include <numeric>
+#include <ranges>
+
+#ifdef Q_OS_MACOS
+#include <QtConcurrent>
+#endif
+
+size_t ComponentHulls::column(const Point & p) const
+{
+    if (m_bounds.width() <= 0) return 0;
+    return std::min(ColumnCount - 1, size_t(std::max(0.0, (p.x() - m_bounds.left()) / m_bounds.width() * ColumnCount)));
+}
+
+void ComponentHulls::consider(Extremes & extremes, size_t i, const Point & p) const
+{
+    auto & e = extremes[column(p)];
+    if (e[0] == -1 || p.y() < m_data->point(e[0]).y())
+        e[0] = i;
+    if (e[1] == -1 || p.y() > m_data->point(e[1]).y())
+        e[1] = i;
+}
+
+void ComponentHulls::update()
+{
+    auto changes = m_data->colorChangesSince(m_colorRevision);
+    const auto & bounds = m_data->bounds();
+    bool boundsChanged = bounds.left() != m_bounds.left() || bounds.right() != m_bounds.right() || bounds.bottom() != m_bounds.bottom() || bounds.top() != m_bounds.top();
+
+    if (!m_valid || changes.all || boundsChanged || m_data->colorComponentCount() != m_componentCount) {
+        rebuild();
+    } else if (!changes.cells.empty()) {
+        // the columns crossing recoloured cells, merged into runs
+        BitSet dirty(ColumnCount);
+        for (const auto & cell : changes.cells)
+            dirty.setRange(column(Point(cell.left(), 0)), column(Point(cell.right(), 0)) + 1);
+        dirty.forEachRun([&](size_t begin, size_t end) {rescanColumns(begin, end - 1);});
+    } else {
+        return;
+    }
+    updateHulls();
+}
+
+// one pass over the selection, shared out in contiguous chunks that each gather their own extremes
+void ComponentHulls::rebuild()
+{
+    m_valid = true;
+    m_bounds = m_data->bounds();
+    m_componentCount = m_data->colorComponentCount();
+    m_extremes.assign(m_componentCount, Extremes(ColumnCount, {size_t(-1), size_t(-1)}));
+    const auto & selected = m_data->selectedIndices();
+    if (m_componentCount < 2 || selected.empty()) return;
+
+    const double limit = 1.0 / m_componentCount;
+    size_t chunkCount = std::max(1, QThread::idealThreadCount());
+    size_t chunkSize = (selected.size() + chunkCount - 1) / chunkCount;
+    std::vector<std::vector<Extremes>> chunkExtremes(chunkCount, std::vector<Extremes>(m_componentCount, Extremes(ColumnCount, {size_t(-1), size_t(-1)})));
+
+#ifndef Q_OS_MACOS
+    auto chunks = std::ranges::views::iota((size_t)0, chunkCount);
+    std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](size_t chunk) {
+#else
+    QList<size_t> chunks(chunkCount, 0);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    QtConcurrent::blockingMap(chunks.begin(), chunks.end(), [&](const size_t & chunk) {
+#endif
+        // positions [first, last) of the selection, walked through the ranges that hold them
+        size_t first = chunk * chunkSize;
+        size_t last = std::min(selected.size(), first + chunkSize);
+        size_t offset = 0;
+        for (const auto & range : selected.ranges()) {
+            size_t length = range[1] - range[0];
+            size_t begin = std::max(first, offset);
+            size_t end = std::min(last, offset + length);
+            for (size_t i = range[0] + begin - offset; begin < end; ++i, ++begin) {
+                const auto & color = m_data->fuzzyColor(i);
+                const auto & p = m_data->point(i);
+                for (size_t k = 1; k < m_componentCount; ++k) {
+                    if (color.weight(k) >= limit)
+                        consider(chunkExtremes[chunk][k], i, p);
+                }
+            }
+            offset += length;
+            if (offset >= last) break;
+        }
+    });
+
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        for (size_t k = 1; k < m_componentCount; ++k) {
+            for (const auto & e : chunkExtremes[chunk][k]) {
+                for (auto i : e) {
+                    if (i != -1)
+                        consider(m_extremes[k], i, m_data->point(i));
+                }
+            }
+        }
+    }
+}
+
+// columns [first, last] are gathered again from the selected droplets in their strip of the data
+void ComponentHulls::rescanColumns(size_t first, size_t last)
+{
+    for (auto & extremes : m_extremes)
+        std::fill(extremes.begin() + first, extremes.begin() + last + 1, std::array<size_t, 2>{size_t(-1), size_t(-1)});
+
+    const double limit = 1.0 / m_componentCount;
+    double w = m_bounds.width() / ColumnCount;
+    OrthogonalRectangle strip(Point(m_bounds.left() + first * w, m_bounds.bottom()), Point(m_bounds.left() + (last + 1) * w, m_bounds.top()));
+    for (auto i : m_data->rectangleSearchSelection(strip)) {
+        const auto & p = m_data->point(i);
+        size_t c = column(p);
+        if (c < first || c > last) continue;
+        const auto & color = m_data->fuzzyColor(i);
+        for (size_t k = 1; k < m_componentCount; ++k) {
+            if (color.weight(k) >= limit)
+                consider(m_extremes[k], i, p);
+        }
+    }
+}
+
+void ComponentHulls::updateHulls()
+{
+    m_hulls.assign(m_componentCount, std::vector<Point>());
+    if (m_componentCount < 2) return;
+    QList<size_t> components(m_componentCount - 1);
+    std::iota(components.begin(), components.end(), 1);
+#ifndef Q_OS_MACOS
+    std::for_each(std::execution::par, components.begin(), components.end(), [&](size_t k) {
+#else
+    QtConcurrent::blockingMap(components.begin(), components.end(), [&](size_t k) {
+#endif
+        std::vector<Point> candidates;
+        for (const auto & e : m_extremes[k]) {
+            if (e[0] != -1)
+                candidates.push_back(m_data->point(e[0]));
+            if (e[1] != -1 && e[1] != e[0])
+                candidates.push_back(m_data->point(e[1]));
+        }
+        m_hulls[k] = Polygon::convexHull(candidates).points();
+    });
+}
@@ -0,0 +1,48 @@
+#ifndef FUZZYDROPLETS_CORE_COMPONENTHULLS_H
+#define FUZZYDROPLETS_CORE_COMPONENTHULLS_H
+
+#include "geometry.h"
+#include <array>
+#include <vector>
+
+class Data;
+
+// convex hulls of the selected droplets of each colour component (those holding at least an even share of it).
+// The data bounds are cut into columns and each component keeps the lowest and highest droplet of every column,
+// only these candidates go into the hull, which then matches the exact hull to within a column's width.
+// A full update gathers the candidates in one parallel pass, after that only the columns crossing recoloured
+// regions of the data are scanned again.
+class ComponentHulls
+{
+public:
+
+    ComponentHulls(Data * data) : m_data(data) {}
+
+    void update();
+    void reset() {m_valid = false;}        // the selection changed, the next update starts again
+
+    size_t hullCount() const {return m_hulls.size();}
+    const std::vector<Point> & hull(size_t component) const {assert(component < m_hulls.size()); return m_hulls[component];}
+
+private:
+
+    using Extremes = std::vector<std::array<size_t, 2>>;   // lowest and highest droplet of each column, or -1
+
+    static const size_t ColumnCount = 1024;
+
+    size_t column(const Point & p) const;
+    void consider(Extremes & extremes, size_t i, const Point & p) const;
+    void rebuild();
+    void rescanColumns(size_t first, size_t last);
+    void updateHulls();
+
+    Data * m_data;
+    bool m_valid {false};
+    size_t m_colorRevision {0};
+    size_t m_componentCount {0};
+    OrthogonalRectangle m_bounds;
+    std::vector<Extremes> m_extremes;       // per component
+    std::vector<std::vector<Point>> m_hulls;
+};
+
+#endif // FUZZYDROPLETS_CORE_COMPONENTHULLS_H
@@ -7,6 +7,7 @@
 #include "hungarianalgorithm.h"
 #include <QtGlobal>
 #include <sstream>
+#include <thread>
 #include <cstdlib>
 
 #include <charconv>
@@ -33,21 +34,39 @@ Data::~Data()
 void Data::setColor(size_t i, const FuzzyColor & color)
 {
     assert(i < m_colors.size());
+    preserveColorChunk(i);
     m_colors[i] = color;
-    m_rgba[i] = color.rgba(m_colorScheme->colors(0, m_colorComponentCount - 1));
+    setRgba(i, m_mixer(color.weights()));
+    markColorChanged(i);
+}
+
+// overwrites the weights of points [begin, end) in place, weights holds colorComponentCount() values per point
+void Data::setColorWeights(size_t begin, size_t end, const double * weights)
+{
+    assert(end <= m_colors.size());
+    for (size_t i = begin; i < end; ++i) {
+        assert(m_colors[i].componentCount() == m_colorComponentCount);
+        preserveColorChunk(i);
+        m_colors[i].setWeights(weights + (i - begin) * m_colorComponentCount);
+        setRgba(i, m_mixer(m_colors[i].weights()));
+        markColorChanged(i);
+    }
 }
 
 void Data::addWeightToColorComponent(size_t i, size_t component, double weight)
 {
     assert(i < m_colors.size());
+    preserveColorChunk(i);
     m_colors[i].setWeight(component, m_colors[i].weight(component) + weight);
     m_colors[i].normalize();
-    m_rgba[i] = m_colors[i].rgba(m_colorScheme->colors(0, m_colorComponentCount - 1));
+    setRgba(i, m_mixer(m_colors[i].weights()));
+    markColorChanged(i);
 }
 
 void Data::setWeightToColorComponent(size_t i, size_t component, double weight)
 {
     assert(i < m_colors.size());
+    preserveColorChunk(i);
     if (component == 0) {
         if (m_colors[i].weight(0) == 1) return;
         m_colors[i].setWeight(0, 0);
@@ -60,63 +79,87 @@ void Data::setWeightToColorComponent(size_t i, size_t component, double weight)
         m_colors[i].setWeight(component, weight);
         m_colors[i].setWeight(0, std::max(0.0, 1.0-m_colors[i].totalWeight()));
     }
-    m_rgba[i] = m_colors[i].rgba(m_colorScheme->colors(0, m_colorComponentCount - 1));
-
+    setRgba(i, m_mixer(m_colors[i].weights()));
+    markColorChanged(i);
 }
 
 void Data::storeColor(size_t i, const FuzzyColor & color)
 {
     assert(i < m_colors.size());
+    preserveColorChunk(i);
     m_colors[i] = color;
+    markColorChanged(i);
 }
 
 void Data::setColor(size_t i, size_t component)
 {
     assert(i < m_colors.size());
+    preserveColorChunk(i);
     assert(component < m_colorComponentCount);
     m_colors[i].setFixedComponent(component);
-    m_rgba[i] = m_colorScheme->color(component);
+    setRgba(i, m_colorScheme->color(component));
+    markColorChanged(i);
 }
 
 void Data::storeColor(size_t i, size_t component)
 {
     assert(i < m_colors.size());
+    preserveColorChunk(i);
     m_colors[i].setFixedComponent(component);
+    markColorChanged(i);
 }
 
+// mixes the selection eagerly on the calling thread, which may be a worker that just stored the colours, so the
+// readers never resolve them while other colours are still being written
 void Data::updateRgbaInSelection()
 {
-    auto baseColors = m_colorScheme->colors(0, m_colorComponentCount - 1);
-    for (auto i : m_selectionIndices) {
+    markAllColorsChanged();
 #ifndef Q_OS_MACOS
-        auto iota = std::ranges::views::iota(m_samples[i][0], m_samples[i][1]);
-        std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t j) {
+    auto iota = std::ranges::views::iota((size_t)0, m_points.size());
+    std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t i) {
 #else
-        QList<size_t> iota(m_samples[i][1] - m_samples[i][0], 0);
-        std::iota(iota.begin(), iota.end(), m_samples[i][0]);
-        QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & j) {
+    QList<size_t> iota(m_points.size(), 0);
+    std::iota(iota.begin(), iota.end(), 0);
+    QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & i) {
 #endif
-            m_rgba[j] = m_colors[j].rgba(baseColors);
-        });
-    }
+        if (isSelected(i))
+            setRgba(i, m_mixer(m_colors[i].weights()));
+    });
 }
 
+// call after changing the colour scheme
 void Data::updateRgba()
 {
-    if (m_points.size() > 0) {
-        const auto baseColors = m_colorScheme->colors(0, m_colorComponentCount - 1);
-
+    markAllColorsChanged();
+    emit storageAboutToChange();
+    updateMixer();
 #ifndef Q_OS_MACOS
-        auto iota = std::ranges::views::iota((size_t)0, m_points.size());
-        std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t j) {
+    auto iota = std::ranges::views::iota((size_t)0, m_rgba.size());
+    std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t i) {
 #else
-        QList<size_t> iota(m_points.size(), 0);
-        std::iota(iota.begin(), iota.end(), 0);
-        QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & j) {
+    QList<size_t> iota(m_rgba.size(), 0);
+    std::iota(iota.begin(), iota.end(), 0);
+    QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & i) {
 #endif
-            m_rgba[j] = m_colors[j].rgba(baseColors);
-        });
-    }
+        setRgba(i, StaleRgba);
+    });
+}
+
+void Data::updateMixer()
+{
+    if (m_colorComponentCount > 0)
+        m_mixer = Color::AdditiveMixer(m_colorScheme->colors(0, m_colorComponentCount - 1));
+}
+
+// mixes the colour of a droplet whose cached rgba was marked stale, and caches it unless a setter got there first.
+// Reads the weights, so readers on other threads are stopped before colours are written (colorsAboutToChange).
+Color::Rgba Data::resolveRgba(size_t i) const
+{
+    Color::Rgba color = m_mixer(m_colors[i].weights());
+    Color::Rgba expected = StaleRgba;
+    if (std::atomic_ref(m_rgba[i]).compare_exchange_strong(expected, color, std::memory_order_relaxed))
+        return color;
+    return expected;
 }
 
 void Data::setDesign(const Design & design)
@@ -140,10 +183,121 @@ void Data::updateDataBounds()
     m_dataBounds = std::accumulate(m_sampleDataBounds.begin(), m_sampleDataBounds.end(), OrthogonalRectangle({std::numeric_limits<double>::max(),std::numeric_limits<double>::max()},{-std::numeric_limits<double>::max(),-std::numeric_limits<double>::max()}), [](const auto & left, const auto & right) {return left.boundingBox(right);});;
 }
 
+void Data::resetColorGrid()
+{
+    if (!m_cellRevisions)
+        m_cellRevisions.reset(new std::atomic<size_t>[ColorGridSize * ColorGridSize]);
+    for (size_t c = 0; c < ColorGridSize * ColorGridSize; ++c)
+        m_cellRevisions[c].store(0, std::memory_order_relaxed);
+    m_sampleRevisions.reset(new std::atomic<size_t>[m_samples.size()]);
+    for (size_t s = 0; s < m_samples.size(); ++s)
+        m_sampleRevisions[s].store(0, std::memory_order_relaxed);
+    m_cellScaleX = m_dataBounds.width() > 0 ? ColorGridSize / m_dataBounds.width() : 0;
+    m_cellScaleY = m_dataBounds.height() > 0 ? ColorGridSize / m_dataBounds.height() : 0;
+    markAllColorsChanged();
+}
+
+// thread safe, the colour setters are called from parallel loops
+void Data::markColorChanged(size_t i)
+{
+    if (!m_cellRevisions) return;
+    const auto & p = m_points[i];
+    size_t cx = std::min(ColorGridSize - 1, size_t(std::max(0.0, (p.x() - m_dataBounds.left()) * m_cellScaleX)));
+    size_t cy = std::min(ColorGridSize - 1, size_t(std::max(0.0, (p.y() - m_dataBounds.bottom()) * m_cellScaleY)));
+    size_t revision = m_colorRevision.load(std::memory_order_relaxed);
+    m_cellRevisions[cy * ColorGridSize + cx].store(revision, std::memory_order_relaxed);
+    size_t sample = std::upper_bound(m_samples.begin(), m_samples.end(), i, [](size_t i, const auto & range) {return i < range[0];}) - m_samples.begin() - 1;
+    m_sampleRevisions[sample].store(revision, std::memory_order_relaxed);
+}
+
+// chunks holding droplets that existed before keep their epochs, new ones are not in any snapshot
+void Data::resizeColorChunks()
+{
+    size_t chunkCount = (m_colors.size() + ColorChunkSize - 1) / ColorChunkSize;
+    std::unique_ptr<std::atomic<size_t>[]> epochs(new std::atomic<size_t>[chunkCount]);
+    for (size_t c = 0; c < chunkCount; ++c)
+        epochs[c].store(c < m_chunkCount ? m_chunkEpochs[c].load(std::memory_order_relaxed) : m_snapshotEpoch, std::memory_order_relaxed);
+    m_chunkEpochs.swap(epochs);
+    m_chunkCount = chunkCount;
+}
+
+Data::ColorSnapshot Data::colorSnapshot()
+{
+    std::erase_if(m_snapshots, [](const auto & snapshot) {return snapshot.expired();});
+    ColorSnapshot snapshot;
+    snapshot.m_state = std::make_shared<ColorSnapshot::State>();
+    snapshot.m_state->colors = &m_colors;
+    snapshot.m_state->size = m_colors.size();
+    snapshot.m_state->chunks.resize((m_colors.size() + ColorChunkSize - 1) / ColorChunkSize);
+    m_snapshots.push_back(snapshot.m_state);
+    ++m_snapshotEpoch;
+    return snapshot;
+}
+
+// the first writer to reach a chunk since the last snapshot copies it for the snapshots reading it live, writers
+// to the same chunk on other threads wait until the copy is done
+void Data::copyColorChunk(size_t chunk)
+{
+    static const size_t Copying = size_t(-1);
+    auto & epoch = m_chunkEpochs[chunk];
+    size_t expected = epoch.load(std::memory_order_acquire);
+    while (expected != m_snapshotEpoch) {
+        if (expected != Copying && epoch.compare_exchange_weak(expected, Copying, std::memory_order_acquire)) {
+            std::shared_ptr<const std::vector<FuzzyColor>> copy;
+            for (const auto & weak : m_snapshots) {
+                auto snapshot = weak.lock();
+                if (!snapshot || chunk >= snapshot->chunks.size() || snapshot->chunks[chunk]) continue;
+                if (!copy)
+                    copy = std::make_shared<const std::vector<FuzzyColor>>(m_colors.begin() + chunk * ColorChunkSize, m_colors.begin() + std::min(m_colors.size(), (chunk + 1) * ColorChunkSize));
+                snapshot->chunks[chunk] = copy;
+            }
+            epoch.store(m_snapshotEpoch, std::memory_order_release);
+            return;
+        }
+        if (expected == Copying)
+            std::this_thread::yield();
+        expected = epoch.load(std::memory_order_acquire);
+    }
+}
+
+IndexRanges Data::ColorSnapshot::changedIndices() const
+{
+    IndexRanges changed;
+    if (!m_state) return changed;
+    for (size_t c = 0; c < m_state->chunks.size(); ++c) {
+        if (m_state->chunks[c])
+            changed.insert(c * ColorChunkSize, std::min(m_state->size, (c + 1) * ColorChunkSize));
+    }
+    return changed;
+}
+
+// the changes made since revision, which is moved on so the next call only reports later changes
+Data::ColorChanges Data::colorChangesSince(size_t & revision)
+{
+    ColorChanges changes;
+    size_t current = m_colorRevision++;
+    changes.all = m_allColorsRevision >= revision || !m_cellRevisions;
+    if (!changes.all) {
+        double w = m_dataBounds.width() / ColorGridSize;
+        double h = m_dataBounds.height() / ColorGridSize;
+        for (size_t c = 0; c < ColorGridSize * ColorGridSize; ++c) {
+            if (m_cellRevisions[c].load(std::memory_order_relaxed) >= revision)
+                changes.cells.push_back(OrthogonalRectangle({m_dataBounds.left() + (c % ColorGridSize) * w, m_dataBounds.bottom() + (c / ColorGridSize) * h}, w, h));
+        }
+        for (size_t s = 0; s < m_samples.size(); ++s) {
+            if (m_sampleRevisions[s].load(std::memory_order_relaxed) >= revision)
+                changes.samples.push_back(s);
+        }
+    }
+    revision = current + 1;
+    return changes;
+}
+
 void Data::setColorZOrder(size_t rgb, size_t pos)
 {
     auto it = std::find(m_colorZOrder.begin(), m_colorZOrder.end(), rgb);
     if (it != m_colorZOrder.end()) {
+        emit storageAboutToChange();
         m_colorZOrder.erase(it);
         m_colorZOrder.insert(m_colorZOrder.begin() + std::clamp(pos, (size_t)0, (size_t)m_colorZOrder.size()), rgb);
         emit colorZOrderChanged(rgb, pos);
@@ -159,6 +313,7 @@ int Data::colorZOrder(size_t color) const
 void Data::setColorComponentCount(size_t count)
 {
     if (count != m_colorComponentCount) {
+        emit storageAboutToChange();
         if (count < m_colorComponentCount) {
             m_colorZOrder.erase(std::remove_if(m_colorZOrder.begin(), m_colorZOrder.end(), [&](size_t i){return i >= count;}), m_colorZOrder.end());
         } else {
@@ -166,7 +321,7 @@ void Data::setColorComponentCount(size_t count)
                 m_colorZOrder.push_back(i);
         }
         m_colorComponentCount = count;
-        auto baseColors = m_colorScheme->colors(0, m_colorComponentCount - 1);
+        updateMixer();
 #ifndef Q_OS_MACOS
         auto iota = std::ranges::views::iota((size_t)0, m_colors.size());
         std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t i) {
@@ -175,9 +330,11 @@ void Data::setColorComponentCount(size_t count)
         std::iota(iota.begin(), iota.end(), 0);
         QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & i) {
 #endif
+            preserveColorChunk(i);
             m_colors[i].setComponentCount(count);
-            m_rgba[i] = m_colors[i].rgba(baseColors);
+            setRgba(i, StaleRgba);
         });
+        markAllColorsChanged();
 
         emit colorCountChanged();
     }
@@ -198,17 +355,20 @@ Color::Rgba Data::nullColor() const
 
 void Data::setSelectedSamples(const std::vector<size_t> & indices)
 {
+    emit colorsAboutToChange();
     m_selectionIndices = indices;
-    std::fill(m_selected.begin(), m_selected.end(), false);
+    m_selectedIndices.clear();
+    for (auto i : indices)
+        m_selectedIndices.insert(m_samples[i][0], m_samples[i][1]);
+    m_selected.fill(false);
 
+    // neighbouring samples can share a word of the selection, which setRange sets atomically
 #ifndef Q_OS_MACOS
-        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](size_t i) {
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&](size_t i) {
 #else
-        QList<size_t> iota(m_colors.size(), 0);
-        std::iota(iota.begin(), iota.end(), 0);
-        QtConcurrent::blockingMap(indices.begin(), indices.end(), [&](const size_t & i) {
+    QtConcurrent::blockingMap(indices.begin(), indices.end(), [&](const size_t & i) {
 #endif
-        std::fill(m_selected.begin() + m_samples[i][0], m_selected.begin() + m_samples[i][1], true);
+        m_selected.setRange(m_samples[i][0], m_samples[i][1]);
     });
     emit selectedSamplesChanged();
 }
@@ -225,11 +385,7 @@ std::vector<Point> Data::randomSelectedPoints(size_t i) const
 {
 #ifdef Q_OS_LINUX
     std::vector<Point> filter;
-    for (size_t i = 0; i < m_points.size(); ++i) {
-        if (isSelected(i)) {
-            filter.push_back(m_points[i]);
-        }
-    }
+    m_selected.forEach([&](size_t i) {filter.push_back(m_points[i]);});
 #else
     auto filter = std::views::zip(m_points, std::ranges::views::iota(0)) | std::views::filter([&](auto elem){return isSelected(std::get<1>(elem));}) | std::views::elements<0>;
 #endif
@@ -292,6 +448,7 @@ std::vector<Point> Data::centroidsByDominantColor(SelectionType type, std::vecto
 
 void Data::deterministicDefuzzifySelection() //todo parallelize
 {
+    emit colorsAboutToChange();
     for (auto i : m_selectionIndices) {
         for (size_t j = m_samples[i][0]; j < m_samples[i][1]; ++j) {
             setColor(j, fuzzyColor(j).dominantComponent());
@@ -304,6 +461,7 @@ void Data::randomlyDefuzzifySelection() // todo parallelize
     std::random_device seed;
     std::mt19937 rng(seed());
     std::uniform_real_distribution<double> dist(0, 1);
+    emit colorsAboutToChange();
     for (auto i : m_selectionIndices) {
         for (size_t j = m_samples[i][0]; j < m_samples[i][1]; ++j) {
             auto r = dist(rng);
@@ -325,6 +483,7 @@ void Data::addSamples(const std::vector<std::string> & paths, std::string & erro
 {
     if (paths.size() == 0) return;
 
+    emit storageAboutToChange();
     std::vector<size_t> addedSamples;
 
     for (auto path : paths) {
@@ -425,10 +584,9 @@ void Data::addSamples(const std::vector<std::string> & paths, std::string & erro
         if (colorCount > m_colorComponentCount)
             setColorComponentCount(colorCount);
 
-        const auto baseColors = m_colorScheme->colors(0, m_colorComponentCount - 1);
         FuzzyColor unassigned(m_colorComponentCount);
         unassigned.setFixedComponent(0);
-        auto unassignedRgb = unassigned.rgba(baseColors);
+        auto unassignedRgb = m_mixer(unassigned.weights());
 
         m_samples.push_back({m_points.size(), m_points.size()});
 
@@ -559,7 +717,7 @@ void Data::addSamples(const std::vector<std::string> & paths, std::string & erro
             }
 
             m_colors.back().normalize();
-            m_rgba.back() =  m_colors.back().rgba(baseColors);
+            m_rgba.back() = StaleRgba;
             ++lineCount;
         }
 
@@ -576,6 +734,7 @@ void Data::addSamples(const std::vector<std::string> & paths, std::string & erro
             m_samples.back()[1] = m_points.size();
             m_samplePaths.push_back(path);
             m_sampleTypes.push_back(Experimental);
+            m_sampleTypeIndices[Experimental].insert(m_samples.back()[0], m_samples.back()[1]);
             auto xRange = std::minmax_element(m_points.begin() + m_samples.back()[0], m_points.begin() + m_samples.back()[1], [](const auto & left, const auto & right) {return left.x() < right.x();});
             auto yRange = std::minmax_element(m_points.begin() + m_samples.back()[0], m_points.begin() + m_samples.back()[1], [](const auto & left, const auto & right) {return left.y() < right.y();});
             m_sampleDataBounds.push_back({{(*xRange.first).x(), (*yRange.first).y()}, {xRange.second->x(), yRange.second->y()}});
@@ -587,6 +746,8 @@ void Data::addSamples(const std::vector<std::string> & paths, std::string & erro
     m_colors.shrink_to_fit();
     m_selected.resize(m_points.size(), false);
     updateDataBounds();
+    resetColorGrid();
+    resizeColorChunks();
     delete m_quadTree;
     m_quadTree = new QuadTree<Point>(m_points, [](const Point & p){return p.x();}, [&](const Point & p){return p.y();});
 
@@ -626,6 +787,7 @@ void Data::matchSelectedColorToUnselectedColors()
     HungarianAlgorithm ha;
     ha.Solve(distMat, assignment);
 
+    emit colorsAboutToChange();
 #ifndef Q_OS_MACOS
     auto iota = std::ranges::views::iota((size_t)0, m_points.size());
     std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t i) {
@@ -692,6 +854,7 @@ void Data::matchColorsToDesign(SelectionType selection)
         }
     }
 
+    emit colorsAboutToChange();
 #ifndef Q_OS_MACOS
     auto iota = std::ranges::views::iota((size_t)0, m_points.size());
     std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t i) {
@@ -735,7 +898,7 @@ std::pair<size_t, double> Data::nearestNeighbourInSelection(Point target, double
 void Data::setSampleType(std::vector<size_t> samples, SampleType type)
 {
     for (auto sample : samples) {
-        m_sampleTypes[sample] = type;
+        updateSampleType(sample, type);
     }
     emit sampleTypesChanged(samples);
 }
@@ -744,7 +907,16 @@ void Data::setSampleType(std::vector<size_t> samples, std::vector<SampleType> ty
 {
     assert(samples.size() == type.size());
     for (int i = 0; i < samples.size(); ++i) {
-        m_sampleTypes[samples[i]] = type[i];
+        updateSampleType(samples[i], type[i]);
     }
     emit sampleTypesChanged(samples);
 }
+
+void Data::updateSampleType(size_t sample, SampleType type)
+{
+    if (m_sampleTypes[sample] != type) {
+        m_sampleTypeIndices[m_sampleTypes[sample]].remove(m_samples[sample][0], m_samples[sample][1]);
+        m_sampleTypeIndices[type].insert(m_samples[sample][0], m_samples[sample][1]);
+        m_sampleTypes[sample] = type;
+    }
+}
@@ -4,12 +4,16 @@
 #include "design.h"
 #include "geometry.h"
 #include "fuzzycolor.h"
+#include "indexranges.h"
+#include "bitset.h"
 
 class Design;
 class ColorScheme;
 template <typename> class QuadTree;
 
 #include <QObject>
+#include <atomic>
+#include <memory>
 
 class Data: public QObject
 {
@@ -52,6 +56,7 @@ public:
     const FuzzyColor & fuzzyColor(size_t i) const {assert(i < m_colors.size()); return m_colors[i];}
     void setColor(size_t i, const FuzzyColor & color);
     void setColor(size_t i, size_t component);
+    void setColorWeights(size_t begin, size_t end, const double * weights);
     void addWeightToColorComponent(size_t i, size_t component, double weight);
     void setWeightToColorComponent(size_t i, size_t component, double weight);
     void storeColor(size_t, const FuzzyColor & color);
@@ -63,17 +68,73 @@ public:
     void updateRgbaInSelection();
     void updateRgba();
 
+    // colour change tracking for partial redraws, the colour setters stamp the cell of a coarse grid over bounds()
+    // that holds the droplet with the current revision. Each view keeps its own revision and asks what changed since.
+    struct ColorChanges
+    {
+        bool all {false};                           // too much changed to list, redraw everything
+        std::vector<OrthogonalRectangle> cells;     // data space areas holding recoloured droplets
+        std::vector<size_t> samples;                // samples holding recoloured droplets
+    };
+    static const size_t ColorGridSize = 64;
+    size_t colorRevision() const {return m_colorRevision;}
+    ColorChanges colorChangesSince(size_t & revision);
+
+    static const size_t ColorChunkSize = 4096;
+
+    // the colours of all droplets as they were when colorSnapshot() took it. Nothing is copied up front, the first
+    // write to a chunk of droplets after a snapshot copies that chunk into the snapshots still reading it from the
+    // live colours, so a snapshot costs only as much as changes after it.
+    class ColorSnapshot
+    {
+        friend class Data;
+
+    public:
+
+        ColorSnapshot() {}
+
+        bool isNull() const {return !m_state;}
+        size_t size() const {return m_state ? m_state->size : 0;}
+        const FuzzyColor & operator[](size_t i) const
+        {
+            assert(i < size());
+            const auto & chunk = m_state->chunks[i / ColorChunkSize];
+            return chunk ? (*chunk)[i % ColorChunkSize] : (*m_state->colors)[i];
+        }
+        IndexRanges changedIndices() const;     // the droplets of chunks written since, only these can differ
+
+    private:
+
+        struct State
+        {
+            const std::vector<FuzzyColor> * colors;
+            size_t size;
+            std::vector<std::shared_ptr<const std::vector<FuzzyColor>>> chunks;
+        };
+
+        std::shared_ptr<State> m_state;
+    };
+    ColorSnapshot colorSnapshot();
+
     int colorZOrder(size_t color) const;
     const std::vector<size_t> & colorZOrder() const {return m_colorZOrder;}
     void setColorZOrder(size_t color, size_t pos);
 
-    Color::Rgba rgba(size_t i) const {assert(i < m_rgba.size()); return m_rgba[i];}
+    // resolved lazily, bulk colour updates only mark the cached rgba stale. Thread safe against other readers, but
+    // not against writers of the droplet's colour.
+    Color::Rgba rgba(size_t i) const
+    {
+        assert(i < m_rgba.size());
+        Color::Rgba color = std::atomic_ref(m_rgba[i]).load(std::memory_order_relaxed);
+        return color != StaleRgba ? color : resolveRgba(i);
+    }
     Color::Rgba nullColor() const;
     void setNullColor(Color::Rgba color);
 
     bool isSelected(size_t point) const {assert(point < m_selected.size()); return m_selected[point];}
-    const std::vector<bool> & selectionFilter() const {return m_selected;}
+    const BitSet & selectionFilter() const {return m_selected;}
     const std::vector<size_t> & selectedSamples() const {return m_selectionIndices;}
+    const IndexRanges & selectedIndices() const {return m_selectedIndices;}
     void setSelectedSamples(const std::vector<size_t> & samples);
     size_t selectedPointCount() const;
     std::vector<Point> randomSelectedPoints(size_t count) const;
@@ -94,6 +155,7 @@ public:
     void setSampleType(std::vector<size_t> samples, SampleType type);
     void setSampleType(std::vector<size_t> samples, std::vector<SampleType> type);
     const std::vector<std::string> & samplePaths() const {return m_samplePaths;}
+    const IndexRanges & sampleTypeIndices(SampleType type) const {return m_sampleTypeIndices[type];}
 
     std::pair<size_t, double> nearestNeighbourInSelection(Point target, double xScale = 1, double yScale = 1, const std::function<bool(size_t)> & filter = [](size_t t){return true;});
     QList<size_t> rectangleSearchSelection(OrthogonalRectangle rect, const std::function<bool(size_t)> & filter = [](size_t t){return true;}) const;
@@ -106,20 +168,39 @@ signals:
     void colorCountChanged();
     void designChanged();
     void fullRepaint();
+    void storageAboutToChange();    // points, colours or the z order are about to be reallocated, or all colours recomputed
+    void colorsAboutToChange();     // colours or the selection are about to be written in place, background readers must stop
     void sampleTypesChanged(std::vector<size_t> samples);
 
 private:
 
     std::array<int, 2> colorCountInFile(const std::string & path) const;
+    void updateSampleType(size_t sample, SampleType type);
     void updateDataBounds();
+    void resetColorGrid();
+    void markColorChanged(size_t i);
+    void markAllColorsChanged() {m_allColorsRevision = m_colorRevision;}
+    void updateMixer();
+    void setRgba(size_t i, Color::Rgba color) {std::atomic_ref(m_rgba[i]).store(color, std::memory_order_relaxed);}
+    Color::Rgba resolveRgba(size_t i) const;
+    void resizeColorChunks();
+    void preserveColorChunk(size_t i)    // call before writing the colour of droplet i, thread safe
+    {
+        if (m_snapshotEpoch != 0 && m_chunkEpochs[i / ColorChunkSize].load(std::memory_order_acquire) != m_snapshotEpoch)
+            copyColorChunk(i / ColorChunkSize);
+    }
+    void copyColorChunk(size_t chunk);
+
+    static const Color::Rgba StaleRgba = 0x00010203;   // a transparent colour no palette mixes to, or if one does it is just mixed again
 
     Design m_design;
     ColorScheme * m_colorScheme {nullptr};
     std::vector<Point> m_points;
     std::vector<std::pair<unsigned char, unsigned char>> m_precision;
     std::vector<FuzzyColor> m_colors;
-    std::vector<Color::Rgba> m_rgba;
-    std::vector<bool> m_selected;
+    mutable std::vector<Color::Rgba> m_rgba;
+    Color::AdditiveMixer m_mixer;
+    BitSet m_selected;
     mutable QuadTree<Point> * m_quadTree {nullptr};
 
     size_t m_colorComponentCount {0};
@@ -132,6 +213,20 @@ private:
     std::vector<std::array<size_t, 2>> m_samples;
     std::vector<std::string> m_samplePaths;
     std::vector<SampleType> m_sampleTypes;
+    std::array<IndexRanges, UnambiguousSample + 1> m_sampleTypeIndices;   // point indices of all samples of each type
+    IndexRanges m_selectedIndices;                                        // point indices of the selected samples
+
+    std::atomic<size_t> m_colorRevision {1};
+    size_t m_allColorsRevision {1};                                       // last revision that recoloured everything
+    std::unique_ptr<std::atomic<size_t>[]> m_cellRevisions;               // last revision that recoloured each grid cell
+    std::unique_ptr<std::atomic<size_t>[]> m_sampleRevisions;             // last revision that recoloured each sample
+    double m_cellScaleX {0};
+    double m_cellScaleY {0};
+
+    size_t m_snapshotEpoch {0};                                           // bumped by every snapshot
+    std::unique_ptr<std::atomic<size_t>[]> m_chunkEpochs;                 // epoch each chunk was last copied for
+    size_t m_chunkCount {0};
+    std::vector<std::weak_ptr<ColorSnapshot::State>> m_snapshots;
 };
 
 #endif // FUZZY_DROPLETS_DATA_H
@@ -0,0 +1,47 @@
+#include "dropletgrid.h"
+#include "data.h"
+#include <limits>
+#include <numeric>
+
+// a counting sort of the droplets by cell
+DropletGrid::DropletGrid(const Data * data, const std::vector<size_t> & indices, double cellSize, size_t maxCells)
+{
+    if (indices.empty() || !(cellSize > 0)) return;
+
+    double right = -std::numeric_limits<double>::infinity();
+    double top = -std::numeric_limits<double>::infinity();
+    m_left = std::numeric_limits<double>::infinity();
+    m_bottom = std::numeric_limits<double>::infinity();
+    for (auto i : indices) {
+        const auto & p = data->point(i);
+        m_left = std::min(m_left, p.x());
+        m_bottom = std::min(m_bottom, p.y());
+        right = std::max(right, p.x());
+        top = std::max(top, p.y());
+    }
+
+    m_cellSize = cellSize;
+    double cells = (std::floor((right - m_left) / m_cellSize) + 1) * (std::floor((top - m_bottom) / m_cellSize) + 1);
+    if (cells > maxCells)
+        m_cellSize *= std::sqrt(cells / maxCells) * 1.001;
+    m_columnCount = size_t(std::floor((right - m_left) / m_cellSize)) + 1;
+    m_rowCount = size_t(std::floor((top - m_bottom) / m_cellSize)) + 1;
+
+    auto cellOf = [&](const Point & p) {
+        size_t c = std::min(m_columnCount - 1, (size_t)std::max(0ll, column(p.x())));
+        size_t r = std::min(m_rowCount - 1, (size_t)std::max(0ll, row(p.y())));
+        return r * m_columnCount + c;
+    };
+
+    m_cellStart.assign(m_columnCount * m_rowCount + 1, 0);
+    for (auto i : indices)
+        ++m_cellStart[cellOf(data->point(i)) + 1];
+    std::partial_sum(m_cellStart.begin(), m_cellStart.end(), m_cellStart.begin());
+
+    std::vector<size_t> next(m_cellStart.begin(), m_cellStart.end() - 1);
+    m_entries.resize(indices.size());
+    for (size_t position = 0; position < indices.size(); ++position) {
+        const auto & p = data->point(indices[position]);
+        m_entries[next[cellOf(p)]++] = {p, position};
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef FUZZYDROPLETS_CORE_DROPLETGRID_H
+#define FUZZYDROPLETS_CORE_DROPLETGRID_H
+
+#include "geometry.h"
+#include <cmath>
+#include <span>
+#include <vector>
+
+class Data;
+
+// a set of droplets binned into square cells over their bounds and stored cell by cell, row after row, so the
+// droplets near a point can be walked without the quadtree. The cells grow beyond the asked size when more than
+// maxCells of them would be needed.
+class DropletGrid
+{
+public:
+
+    struct Entry
+    {
+        Point point;
+        size_t position;        // in the indices the grid was built from
+    };
+
+    DropletGrid(const Data * data, const std::vector<size_t> & indices, double cellSize, size_t maxCells);
+
+    size_t columnCount() const {return m_columnCount;}
+    size_t rowCount() const {return m_rowCount;}
+    double cellSize() const {return m_cellSize;}
+
+    // unclamped, so they may lie outside the grid
+    long long column(double x) const {return (long long)std::floor((x - m_left) / m_cellSize);}
+    long long row(double y) const {return (long long)std::floor((y - m_bottom) / m_cellSize);}
+    double left(long long column) const {return m_left + column * m_cellSize;}
+    double bottom(long long row) const {return m_bottom + row * m_cellSize;}
+
+    std::span<const Entry> cell(size_t column, size_t row) const
+    {
+        size_t i = row * m_columnCount + column;
+        return std::span<const Entry>(m_entries.data() + m_cellStart[i], m_cellStart[i + 1] - m_cellStart[i]);
+    }
+    std::span<const Entry> cells(size_t row) const      // a whole row
+    {
+        return std::span<const Entry>(m_entries.data() + m_cellStart[row * m_columnCount], m_cellStart[(row + 1) * m_columnCount] - m_cellStart[row * m_columnCount]);
+    }
+
+private:
+
+    double m_left {0};
+    double m_bottom {0};
+    double m_cellSize {1};
+    size_t m_columnCount {0};
+    size_t m_rowCount {0};
+    std::vector<size_t> m_cellStart;        // columnCount * rowCount + 1 offsets into m_entries
+    std::vector<Entry> m_entries;
+};
+
+#endif // FUZZYDROPLETS_CORE_DROPLETGRID_H
@@ -35,8 +35,7 @@ public:
 
         m_pointIota = QList<size_t>();
         m_pointIota.reserve(data->selectedPointCount());
-        for (int i = 0; i < data->pointCount(); ++i)
-            if (data->isSelected(i)) m_pointIota.push_back(i);
+        data->selectionFilter().forEach([&](size_t i) {m_pointIota.push_back(i);});
 
         m_dists.resize(numClusters);
     }
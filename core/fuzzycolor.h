@@ -4,6 +4,7 @@
 #include <vector>
 #include <cassert>
 #include <numeric>
+#include <algorithm>
 #include "color.h"
 #include "approximately.h"
 
@@ -78,6 +79,12 @@ public:
         m_weights = weights;
     }
 
+    // copies componentCount() weights in place, without reallocating
+    void setWeights(const double * weights)
+    {
+        std::copy(weights, weights + m_weights.size(), m_weights.begin());
+    }
+
     double weight(size_t component) const
     {
         assert(component < m_weights.size());
@@ -0,0 +1,84 @@
+#include "geometry.h"
+#include <QThread>
+#include <QtGlobal>
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <ranges>
+
+#ifdef Q_OS_MACOS
+#include <QtConcurrent>
+#endif
+
+namespace {
+
+// > 0 when o, a, b turn counterclockwise
+double cross(const Point & o, const Point & a, const Point & b)
+{
+    return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+// Andrew's monotone chain over distinct points sorted by x then y, written clockwise to hull: the upper chain from
+// the leftmost to the rightmost point, then the lower chain back. Collinear points leave only the two end points.
+void monotoneChain(const std::vector<Point> & sorted, std::vector<Point> & hull)
+{
+    hull.clear();
+    if (sorted.size() < 3) {
+        hull = sorted;
+        return;
+    }
+    for (const auto & p : sorted) {
+        while (hull.size() >= 2 && cross(hull[hull.size() - 2], hull.back(), p) >= 0)
+            hull.pop_back();
+        hull.push_back(p);
+    }
+    size_t upper = hull.size();
+    for (auto it = sorted.rbegin() + 1; it != sorted.rend(); ++it) {
+        while (hull.size() > upper && cross(hull[hull.size() - 2], hull.back(), *it) >= 0)
+            hull.pop_back();
+        hull.push_back(*it);
+    }
+    hull.pop_back();    // the leftmost point again
+}
+
+}
+
+// the sorted copy and the chain live in buffers kept by each thread, so repeated hulls allocate only their result
+Polygon Polygon::convexHull(std::span<const Point> data)
+{
+    thread_local std::vector<Point> sorted;
+    thread_local std::vector<Point> hull;
+    sorted.assign(data.begin(), data.end());
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    monotoneChain(sorted, hull);
+    return Polygon(std::vector<Point>(hull.begin(), hull.end()));
+}
+
+Polygon Polygon::parallelConvexHull(std::span<const Point> data)
+{
+    static const size_t MinChunkSize = 16384;
+    size_t chunkCount = std::clamp(data.size() / MinChunkSize, (size_t)1, (size_t)std::max(1, QThread::idealThreadCount()));
+    if (chunkCount == 1) return convexHull(data);
+
+    size_t chunkSize = (data.size() + chunkCount - 1) / chunkCount;
+    std::vector<std::vector<Point>> chunkHulls(chunkCount);
+#ifndef Q_OS_MACOS
+    auto chunks = std::ranges::views::iota((size_t)0, chunkCount);
+    std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](size_t chunk) {
+#else
+    QList<size_t> chunks(chunkCount, 0);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    QtConcurrent::blockingMap(chunks.begin(), chunks.end(), [&](const size_t & chunk) {
+#endif
+        size_t first = chunk * chunkSize;
+        auto part = data.subspan(first, std::min(chunkSize, data.size() - first));
+        chunkHulls[chunk] = convexHull(part).points();
+    });
+
+    // the hull of the data is the hull of the vertices of its chunks' hulls
+    std::vector<Point> vertices;
+    for (const auto & hull : chunkHulls)
+        vertices.insert(vertices.end(), hull.begin(), hull.end());
+    return convexHull(vertices);
+}
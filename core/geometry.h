@@ -6,6 +6,7 @@
 #include <vector>
 #include <functional>
 #include <array>
+#include <span>
 
 class Point
 {
@@ -188,61 +189,20 @@ public:
         return x / 2;
     }
 
-    static Polygon convexHull(const std::vector<Point> & data)
+    double perimeter() const
     {
-        if (data.empty()) {
-            return Polygon();
-        } else {
-            std::function<void(const std::vector<Point>&, const Point&, const Point&, std::vector<Point>&)> quickHull = [&](const std::vector<Point>& v, const Point& a, const Point& b, std::vector<Point>& hull)
-            {
-                if (v.empty())
-                    return;
-
-                size_t idxMax = 0;
-                double distMax = Line(a,b).distanceTo(v[idxMax]);
-                for (size_t i = 1; i < v.size(); ++i) {
-                    double distCurr = Line(a,b).distanceTo(v[i]);
-                    if (distCurr > distMax) {
-                        idxMax = i;
-                        distMax = distCurr;
-                    }
-                }
-                Point f = v[idxMax];
-
-                std::vector<Point> left;
-                for (auto & p : v) {
-                    if ((f.x() - a.x()) * (p.y() - a.y()) - (f.y() - a.y()) * (p.x() - a.x()) > 0) {
-                        left.push_back(p);
-                    }
-                }
-                quickHull(left, a, f, hull);
-                hull.push_back(f);
-                std::vector<Point> right;
-                for (auto & p : v) {
-                    if ((b.x() - f.x()) * (p.y() - f.y()) - (b.y() - f.y()) * (p.x() - f.x()) > 0) {
-                        right.push_back(p);
-                    }
-                }
-                quickHull(right, f, b, hull);
-            };
-
-            std::vector<Point> hull;
-            if (data.size() <= 2) return Polygon(hull);
-
-            Point a = *min_element(data.begin(), data.end(), [](const Point & a, const Point & b) {return (a.x() < b.x() || (a.x() == b.x() && a.y() < b.y()));});
-            Point b = *max_element(data.begin(), data.end(), [](const Point & a, const Point & b) {return (a.x() < b.x() || (a.x() == b.x() && a.y() < b.y()));});
+        double x = 0;
+        for (size_t i = 0, j = m_points.size() - 1; i < m_points.size(); j = i++)
+            x += m_points[i].distanceTo(m_points[j]);
+        return x;
+    }
 
-            std::vector<Point> left, right;
-            for (auto & p : data)
-                ((b.x() - a.x()) * (p.y() - a.y()) - (b.y() - a.y()) * (p.x() - a.x())) > 0 ? left.push_back(p) : right.push_back(p);
+    // clockwise from the leftmost point, just the two end points if the points all lie on one line
+    static Polygon convexHull(std::span<const Point> data);
+    static Polygon convexHull(const std::vector<Point> & data) {return convexHull(std::span<const Point>(data));}
 
-            hull.push_back(a);
-            quickHull(left, a, b, hull);
-            hull.push_back(b);
-            quickHull(right, b, a, hull);
-            return Polygon(hull);
-        }
-    }
+    // hulls contiguous chunks of the data in parallel, then the hull of their vertices
+    static Polygon parallelConvexHull(std::span<const Point> data);
 
     const std::vector<Point> points() const
     {
@@ -0,0 +1,154 @@
+#ifndef FUZZY_DROPLETS_INDEXRANGES_H
+#define FUZZY_DROPLETS_INDEXRANGES_H
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cassert>
+
+// A sorted set of point indices stored as disjoint [begin, end) ranges, e.g. the droplets of every sample of one type.
+// Positions 0..size()-1 run through the ranges in order, so it stands in for a list of indices without materialising it.
+
+class IndexRanges
+{
+public:
+
+    using Range = std::array<size_t, 2>;
+
+    class const_iterator
+    {
+    public:
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const size_t *;
+        using reference = size_t;
+
+        const_iterator() {}
+        const_iterator(const std::vector<Range> * ranges, size_t range, size_t index) : m_ranges(ranges), m_range(range), m_index(index) {}
+
+        size_t operator*() const {return m_index;}
+
+        const_iterator & operator++()
+        {
+            if (++m_index == (*m_ranges)[m_range][1]) {
+                ++m_range;
+                m_index = m_range < m_ranges->size() ? (*m_ranges)[m_range][0] : 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {auto it = *this; ++*this; return it;}
+
+        bool operator==(const const_iterator & other) const {return m_range == other.m_range && m_index == other.m_index;}
+
+    private:
+
+        const std::vector<Range> * m_ranges {nullptr};
+        size_t m_range {0};
+        size_t m_index {0};
+    };
+
+    IndexRanges() {}
+
+    size_t size() const {return m_size;}
+    bool empty() const {return m_size == 0;}
+    const std::vector<Range> & ranges() const {return m_ranges;}
+
+    const_iterator begin() const {return m_ranges.empty() ? end() : const_iterator(&m_ranges, 0, m_ranges[0][0]);}
+    const_iterator end() const {return const_iterator(&m_ranges, m_ranges.size(), 0);}
+
+    // index at a position, logarithmic in the number of ranges
+    size_t operator[](size_t pos) const
+    {
+        assert(pos < m_size);
+        size_t r = std::upper_bound(m_offsets.begin(), m_offsets.end(), pos) - m_offsets.begin() - 1;
+        return m_ranges[r][0] + pos - m_offsets[r];
+    }
+
+    void clear()
+    {
+        m_ranges.clear();
+        m_offsets.clear();
+        m_size = 0;
+    }
+
+    // adds [begin, end), merging with touching or overlapping ranges
+    void insert(size_t begin, size_t end)
+    {
+        if (begin >= end) return;
+        auto first = std::lower_bound(m_ranges.begin(), m_ranges.end(), begin, [](const Range & r, size_t i) {return r[1] < i;});
+        auto last = std::upper_bound(first, m_ranges.end(), end, [](size_t i, const Range & r) {return i < r[0];});
+        if (first != last) {
+            begin = std::min(begin, (*first)[0]);
+            end = std::max(end, (*(last - 1))[1]);
+            first = m_ranges.erase(first, last);
+        }
+        m_ranges.insert(first, {begin, end});
+        updateOffsets();
+    }
+
+    void insert(const IndexRanges & other)
+    {
+        for (const auto & r : other.m_ranges)
+            insert(r[0], r[1]);
+    }
+
+    // removes [begin, end), splitting ranges that contain it
+    void remove(size_t begin, size_t end)
+    {
+        if (begin >= end) return;
+        std::vector<Range> result;
+        result.reserve(m_ranges.size() + 1);
+        for (const auto & r : m_ranges) {
+            if (r[1] <= begin || r[0] >= end) {
+                result.push_back(r);
+            } else {
+                if (r[0] < begin)
+                    result.push_back({r[0], begin});
+                if (r[1] > end)
+                    result.push_back({end, r[1]});
+            }
+        }
+        m_ranges = std::move(result);
+        updateOffsets();
+    }
+
+    void remove(const IndexRanges & other)
+    {
+        for (const auto & r : other.m_ranges)
+            remove(r[0], r[1]);
+    }
+
+    // the ranges cut into pieces of at most blockSize indices, to share out in parallel loops
+    std::vector<Range> blocks(size_t blockSize) const
+    {
+        std::vector<Range> result;
+        result.reserve(m_size / blockSize + m_ranges.size());
+        for (const auto & r : m_ranges) {
+            for (size_t i = r[0]; i < r[1]; i += blockSize)
+                result.push_back({i, std::min(i + blockSize, r[1])});
+        }
+        return result;
+    }
+
+private:
+
+    void updateOffsets()
+    {
+        m_offsets.resize(m_ranges.size());
+        m_size = 0;
+        for (size_t r = 0; r < m_ranges.size(); ++r) {
+            m_offsets[r] = m_size;
+            m_size += m_ranges[r][1] - m_ranges[r][0];
+        }
+    }
+
+    std::vector<Range> m_ranges;
+    std::vector<size_t> m_offsets;  // position of the first index of each range
+    size_t m_size {0};
+};
+
+#endif // FUZZY_DROPLETS_INDEXRANGES_H
@@ -1,6 +1,7 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 
+#include <cmath>
 #include <concepts>
 #include <numbers>
 
@@ -8,9 +9,16 @@ template <std::floating_point T>
 struct Kernel
 {
     virtual T weight(T pos, T location = 0, T scale = 1) const = 0;
+    static constexpr T support = 1;     // weights are zero (or cut off) from this many scales out
     virtual ~Kernel() {}
 };
 
+template <std::floating_point T>
+struct UniformKernel : public Kernel<T>
+{
+    inline T weight(T u, T location = 0, T scale = 1) const {return T(0.5) / scale;}
+};
+
 template <std::floating_point T>
 struct EpanechnikovKernel : public Kernel<T>
 {
@@ -41,4 +49,11 @@ struct CosineKernel : public Kernel<T>
     inline T weight(T u, T location = 0, T scale = 1) const {return std::numbers::pi_v<T> * cos(std::numbers::pi_v<T> * ((u - location)/scale) / 2) / (4 * scale);}
 };
 
+template <std::floating_point T>
+struct GaussianKernel : public Kernel<T>
+{
+    inline T weight(T u, T location = 0, T scale = 1) const {return exp(-pow((u - location)/scale, 2) / 2) / (scale * std::sqrt(2 * std::numbers::pi_v<T>));}
+    static constexpr T support = 3;
+};
+
 #endif // KERNEL_H
@@ -0,0 +1,111 @@
+#include "kernelsmoothing.h"
+#include "kernel.h"
+#include "data.h"
+#include <QtGlobal>
+#include <execution>
+#include <numeric>
+#include <ranges>
+
+#ifdef Q_OS_MACOS
+#include <QtConcurrent>
+#endif
+
+template <typename K>
+KernelSmoothing<K>::KernelSmoothing(const Data * data, const std::vector<size_t> & indices, double xBandwidth, double yBandwidth)
+    : m_data(data),
+    m_indices(indices),
+    m_xBandwidth(xBandwidth),
+    m_yBandwidth(yBandwidth),
+    m_componentCount(data->colorComponentCount()),
+    m_grid(data, m_indices, K::support * std::min(xBandwidth, yBandwidth) / CellsPerBandwidth, MaxCells)
+{
+}
+
+// the rows of cells within the kernel's support, each clipped to the chord of its ellipse nearest to the droplet
+template <typename K>
+void KernelSmoothing<K>::smooth(const DropletGrid::Entry & entry, std::vector<double> & sums) const
+{
+    std::ranges::fill(sums, 0);
+    const double support2 = K::support * K::support;
+    const auto & p = entry.point;
+    const long long lastColumn = m_grid.columnCount() - 1;
+    long long firstRow = std::max(0ll, m_grid.row(p.y() - K::support * m_yBandwidth));
+    long long lastRow = std::min((long long)m_grid.rowCount() - 1, m_grid.row(p.y() + K::support * m_yBandwidth));
+
+    for (long long r = firstRow; r <= lastRow; ++r) {
+        double y0 = m_grid.bottom(r);
+        double y1 = m_grid.bottom(r + 1);
+        double nearY = (p.y() < y0 ? y0 - p.y() : (p.y() > y1 ? p.y() - y1 : 0)) / m_yBandwidth;
+        if (nearY >= K::support) continue;
+
+        double reach = m_xBandwidth * std::sqrt(support2 - nearY * nearY);
+        long long c0 = std::max(0ll, m_grid.column(p.x() - reach));
+        long long c1 = std::min(lastColumn, m_grid.column(p.x() + reach));
+        for (long long c = c0; c <= c1; ++c) {
+            for (const auto & other : m_grid.cell(c, r)) {
+                double dx = (other.point.x() - p.x()) / m_xBandwidth;
+                double dy = (other.point.y() - p.y()) / m_yBandwidth;
+                double u2 = dx * dx + dy * dy;
+                if (u2 < support2) {
+                    double weight = m_kernel.weight(std::sqrt(u2));
+                    const auto & color = m_data->fuzzyColor(m_indices[other.position]);
+                    for (size_t k = 0; k < m_componentCount; ++k)
+                        sums[k] += weight * std::max(0.0, color.weight(k));
+                    sums[m_componentCount] += weight;
+                }
+            }
+        }
+    }
+}
+
+template <typename K>
+std::vector<FuzzyColor> KernelSmoothing<K>::run(const std::function<void(int)> & progress, const std::atomic<bool> * cancelled) const
+{
+    std::vector<FuzzyColor> colors(m_indices.size());
+    if (m_grid.rowCount() == 0) {
+        for (size_t i = 0; i < m_indices.size(); ++i)
+            colors[i] = m_data->fuzzyColor(m_indices[i]);
+        return colors;
+    }
+    std::atomic<size_t> done = 0;
+    std::atomic<int> percent = 0;
+
+#ifndef Q_OS_MACOS
+    auto rows = std::ranges::views::iota((size_t)0, m_grid.rowCount());
+    std::for_each(std::execution::par, rows.begin(), rows.end(), [&](size_t r) {
+#else
+    QList<size_t> rows(m_grid.rowCount(), 0);
+    std::iota(rows.begin(), rows.end(), 0);
+    QtConcurrent::blockingMap(rows.begin(), rows.end(), [&](const size_t & r) {
+#endif
+        if (cancelled && *cancelled) return;
+        std::vector<double> sums(m_componentCount + 1);
+        auto entries = m_grid.cells(r);
+        for (const auto & entry : entries) {
+            smooth(entry, sums);
+            if (sums[m_componentCount] <= 0) {
+                colors[entry.position] = m_data->fuzzyColor(m_indices[entry.position]);
+            } else {
+                colors[entry.position] = FuzzyColor(std::vector<double>(sums.begin(), sums.begin() + m_componentCount));
+                colors[entry.position].normalize();
+            }
+        }
+
+        int newPercent = int(100 * (done += entries.size()) / m_indices.size());
+        int oldPercent = percent;
+        while (newPercent > oldPercent && !percent.compare_exchange_weak(oldPercent, newPercent)) {}
+        if (progress && newPercent > oldPercent)
+            progress(newPercent);
+    });
+
+    if (cancelled && *cancelled)
+        return std::vector<FuzzyColor>();
+    return colors;
+}
+
+template class KernelSmoothing<EpanechnikovKernel<double>>;
+template class KernelSmoothing<QuarticKernel<double>>;
+template class KernelSmoothing<TriWeightKernel<double>>;
+template class KernelSmoothing<TricubeKernel<double>>;
+template class KernelSmoothing<CosineKernel<double>>;
+template class KernelSmoothing<GaussianKernel<double>>;
@@ -0,0 +1,42 @@
+#ifndef FUZZYDROPLETS_CORE_KERNELSMOOTHING_H
+#define FUZZYDROPLETS_CORE_KERNELSMOOTHING_H
+
+#include "dropletgrid.h"
+#include "fuzzycolor.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+class Data;
+
+// replaces the colour of each droplet with the mean of the (non-negative) colours of the droplets around it, among
+// the given droplets, each weighted by K at its distance scaled by the x and y bandwidths. The kernel is a template
+// parameter so its weights are inlined into the loop, instantiations exist for each kernel in kernel.h.
+template <typename K>
+class KernelSmoothing
+{
+public:
+
+    KernelSmoothing(const Data * data, const std::vector<size_t> & indices, double xBandwidth, double yBandwidth);
+
+    // the new colours in the order of indices, or none once cancelled is set. Progress is given percentages from
+    // the worker threads.
+    std::vector<FuzzyColor> run(const std::function<void(int)> & progress = nullptr, const std::atomic<bool> * cancelled = nullptr) const;
+
+private:
+
+    static const int CellsPerBandwidth = 2;
+    static const size_t MaxCells = 1 << 22;
+
+    void smooth(const DropletGrid::Entry & entry, std::vector<double> & sums) const;
+
+    const Data * m_data;
+    std::vector<size_t> m_indices;
+    double m_xBandwidth;
+    double m_yBandwidth;
+    size_t m_componentCount;
+    DropletGrid m_grid;
+    K m_kernel;
+};
+
+#endif // FUZZYDROPLETS_CORE_KERNELSMOOTHING_H
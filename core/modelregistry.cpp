@@ -0,0 +1,42 @@
+#include "modelregistry.h"
+#include <algorithm>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+
+const QString ModelRegistry::Extension = "fdforest";
+
+ModelRegistry::ModelRegistry()
+    : m_directory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/models")
+{
+    QDir().mkpath(m_directory);
+}
+
+QStringList ModelRegistry::modelNames() const
+{
+    QStringList names;
+    for (auto & info : QDir(m_directory).entryInfoList({"*." + Extension}, QDir::Files, QDir::Name))
+        names.push_back(info.completeBaseName());
+    return names;
+}
+
+bool ModelRegistry::contains(const QString & name) const
+{
+    return isValidName(name) && QFile::exists(modelPath(name));
+}
+
+QString ModelRegistry::modelPath(const QString & name) const
+{
+    return m_directory + "/" + name + "." + Extension;
+}
+
+bool ModelRegistry::removeModel(const QString & name)
+{
+    return contains(name) && QFile::remove(modelPath(name));
+}
+
+bool ModelRegistry::isValidName(const QString & name)
+{
+    static const QString forbidden = "/\\:*?\"<>|";
+    return !name.trimmed().isEmpty() && !name.startsWith('.') && std::ranges::none_of(name, [](QChar c) {return forbidden.contains(c);});
+}
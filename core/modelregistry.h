@@ -0,0 +1,31 @@
+#ifndef FUZZY_DROPLETS_MODELREGISTRY_H
+#define FUZZY_DROPLETS_MODELREGISTRY_H
+
+#include <QString>
+#include <QStringList>
+
+// Trained random forests kept in the application data directory so they can be applied to later plates.
+// Models are stored one per file in ranger's binary model format, named after the model.
+
+class ModelRegistry
+{
+public:
+
+    ModelRegistry();
+
+    const QString & directory() const {return m_directory;}
+    QStringList modelNames() const;
+    bool contains(const QString & name) const;
+    QString modelPath(const QString & name) const;
+    bool removeModel(const QString & name);
+
+    static bool isValidName(const QString & name);
+
+    static const QString Extension;
+
+private:
+
+    QString m_directory;
+};
+
+#endif // FUZZY_DROPLETS_MODELREGISTRY_H
@@ -4,6 +4,7 @@
 #include <QWidget>
 #include "../core/geometry.h"
 #include "../core/quadtree.h"
+#include "../core/indexranges.h"
 
 class Droplet;
 class Data;
@@ -17,7 +18,7 @@ public:
     AssignmentMethodWidget(QWidget *parent = nullptr);
     virtual ~AssignmentMethodWidget();
 
-    virtual void run(const QList<size_t> & sourceIndices, const QList<size_t> & targetIndices) {};
+    virtual void run(const IndexRanges & sourceIndices, const IndexRanges & targetIndices) {};
     virtual void cancel() {}
 
     virtual bool requiresLaunchWidget() const {return true;}        // reimplement to request no launch widget, continuous updates instead
@@ -57,6 +57,7 @@ AssignmentWidget::AssignmentWidget(Data * data, PaintingWidget * painting, Dropl
     m_launchWidget->hide();
 
     connect(m_targetComboBox, &QComboBox::currentIndexChanged, this, &AssignmentWidget::updateLaunchStatus);
+    connect(m_unambCB, &QCheckBox::stateChanged, this, &AssignmentWidget::updateLaunchStatus);
     connect(m_posCB, &QCheckBox::stateChanged, this, &AssignmentWidget::updateLaunchStatus);
     connect(m_negCB, &QCheckBox::stateChanged, this, &AssignmentWidget::updateLaunchStatus);
     connect(m_ntcCB, &QCheckBox::stateChanged, this, &AssignmentWidget::updateLaunchStatus);
@@ -145,85 +146,30 @@ void AssignmentWidget::run()
 
     auto source = sourceIndices();
     auto target = targetIndices();
-    if (source.size() > 0 && target.size() > 0)
-    c->run(source, target);
+    if (!source.empty() && !target.empty())
+        c->run(source, target);
 }
 
-QList<size_t> AssignmentWidget::targetIndices() const
+IndexRanges AssignmentWidget::targetIndices() const
 {
-    QList<size_t> target;
-    if (m_targetComboBox->currentIndex() == 0) { // target sample data
-        for (int i = 0; i < m_data->sampleCount(); ++i) {
-            if (m_data->sampleType(i) == Data::SampleType::Experimental) {
-                auto bounds = m_data->sampleIndices(i);
-                for (auto i = bounds[0]; i < bounds[1]; ++i) {
-                    target.push_back(i);
-                }
-            }
-        }
-    } else { // target selection
-        for (auto sampleIdx : m_data->selectedSamples()) {
-            auto bounds = m_data->sampleIndices(sampleIdx);
-            for (auto i = bounds[0]; i < bounds[1]; ++i) {
-                target.push_back(i);
-            }
-        }
-    }
-    return target;
+    if (m_targetComboBox->currentIndex() == 0) // target sample data
+        return m_data->sampleTypeIndices(Data::SampleType::Experimental);
+    return m_data->selectedIndices();
 }
 
-QList<size_t> AssignmentWidget::sourceIndices() const
+IndexRanges AssignmentWidget::sourceIndices() const
 {
-    QList<size_t> source;
-
-    if (m_posCB->isChecked()) {
-        for (int i = 0; i < m_data->sampleCount(); ++i) {
-            if (m_data->sampleType(i) == Data::SampleType::PositiveControl && !(m_targetComboBox->currentIndex() == 0 && m_data->sampleType(i) == Data::SampleType::Experimental)) {
-                auto bounds = m_data->sampleIndices(i);
-                for (auto j = bounds[0]; j < bounds[1]; ++j) {
-                    if (!(m_targetComboBox->currentIndex() == 1 && m_data->isSelected(j)))
-                        source.push_back(j);
-                }
-            }
-        }
-    }
-
-    if (m_negCB->isChecked()) {
-        for (int i = 0; i < m_data->sampleCount(); ++i) {
-            if (m_data->sampleType(i) == Data::SampleType::NegativeControl && !(m_targetComboBox->currentIndex() == 0 && m_data->sampleType(i) == Data::SampleType::Experimental)) {
-                auto bounds = m_data->sampleIndices(i);
-                for (auto j = bounds[0]; j < bounds[1]; ++j) {
-                    if (!(m_targetComboBox->currentIndex() == 1 && m_data->isSelected(j)))
-                        source.push_back(j);
-                }
-            }
-        }
-    }
-
-    if (m_ntcCB->isChecked()) {
-        for (int i = 0; i < m_data->sampleCount(); ++i) {
-            if (m_data->sampleType(i) == Data::SampleType::NonTemplateControl && !(m_targetComboBox->currentIndex() == 0 && m_data->sampleType(i) == Data::SampleType::Experimental)) {
-                auto bounds = m_data->sampleIndices(i);
-                for (auto j = bounds[0]; j < bounds[1]; ++j) {
-                    if (!(m_targetComboBox->currentIndex() == 1 && m_data->isSelected(j)))
-                        source.push_back(j);
-                }
-            }
-        }
-    }
-
-    if (m_unambCB->isChecked()) {
-        for (int i = 0; i < m_data->sampleCount(); ++i) {
-            if (m_data->sampleType(i) == Data::SampleType::UnambiguousSample && !(m_targetComboBox->currentIndex() == 0 && m_data->sampleType(i) == Data::SampleType::Experimental)) {
-                auto bounds = m_data->sampleIndices(i);
-                for (auto j = bounds[0]; j < bounds[1]; ++j) {
-                    if (!(m_targetComboBox->currentIndex() == 1 && m_data->isSelected(j)))
-                        source.push_back(j);
-                }
-            }
-        }
-    }
-
+    IndexRanges source;
+    if (m_posCB->isChecked())
+        source.insert(m_data->sampleTypeIndices(Data::SampleType::PositiveControl));
+    if (m_negCB->isChecked())
+        source.insert(m_data->sampleTypeIndices(Data::SampleType::NegativeControl));
+    if (m_ntcCB->isChecked())
+        source.insert(m_data->sampleTypeIndices(Data::SampleType::NonTemplateControl));
+    if (m_unambCB->isChecked())
+        source.insert(m_data->sampleTypeIndices(Data::SampleType::UnambiguousSample));
+    if (m_targetComboBox->currentIndex() == 1) // selected samples are targets, never sources
+        source.remove(m_data->selectedIndices());
     return source;
 }
 
@@ -256,35 +202,7 @@ void AssignmentWidget::cancel()
 
 void AssignmentWidget::updateLaunchStatus()
 {
-    bool targetIsValid = false;
-    if (m_targetComboBox->currentIndex() == 0) { // target sample data
-        for (int i = 0; i < m_data->sampleCount(); ++i) {
-            if (m_data->sampleType(i) == Data::Experimental) {
-                targetIsValid = true;
-                break;
-            }
-        }
-    } else { // target selection
-        targetIsValid = (m_data->selectedSamples().size() > 0);
-    }
-
-    bool sourceIsValid = false;
-    for (size_t i = 0; i < m_data->sampleCount(); ++i) {
-        if (m_posCB->isChecked() && m_data->sampleType(i) == Data::PositiveControl && (m_targetComboBox->currentIndex() == 0 || std::find(m_data->selectedSamples().begin(), m_data->selectedSamples().end(), i) == m_data->selectedSamples().end())) {
-            sourceIsValid = true;
-            break;
-        }
-        if (m_negCB->isChecked() && m_data->sampleType(i) == Data::NegativeControl && (m_targetComboBox->currentIndex() == 0 || std::find(m_data->selectedSamples().begin(), m_data->selectedSamples().end(), i) == m_data->selectedSamples().end())) {
-            sourceIsValid = true;
-            break;
-        }
-        if (m_ntcCB->isChecked() && m_data->sampleType(i) == Data::NonTemplateControl && (m_targetComboBox->currentIndex() == 0 || std::find(m_data->selectedSamples().begin(), m_data->selectedSamples().end(), i) == m_data->selectedSamples().end())) {
-            sourceIsValid = true;
-            break;
-        }
-    }
-
-    m_launchWidget->setEnabled(sourceIsValid && targetIsValid);
+    m_launchWidget->setEnabled(!sourceIndices().empty() && !targetIndices().empty());
 }
 
 void AssignmentWidget::sampleTypesChanged(std::vector<size_t> samples)
@@ -3,6 +3,7 @@
 
 #include <QWidget>
 #include "../core/fuzzycolor.h"
+#include "../core/indexranges.h"
 
 class StackedWidget;
 class LaunchWidget;
@@ -23,8 +24,8 @@ public:
 
     explicit AssignmentWidget(Data * data, PaintingWidget * painting, DropletGraphWidget * graph, SampleListWidget * sampleList, CommandStack * commandStack, QWidget *parent = nullptr);
 
-    QList<size_t> sourceIndices() const;
-    QList<size_t> targetIndices() const;
+    IndexRanges sourceIndices() const;
+    IndexRanges targetIndices() const;
 
 public slots:
 
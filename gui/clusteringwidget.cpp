@@ -105,11 +105,8 @@ void ClusteringWidget::showLaunchWidget()
 
 void ClusteringWidget::run()
 {
-    // back up the original colours so we can restore them if the run is cancelled or if the user clicks undo
-    m_originalColors.clear();
-    m_originalColors.reserve(m_data->selectedPointCount());
-    for (size_t i = 0; i < m_data->points().size(); ++i)
-        if (m_data->isSelected(i)) m_originalColors.push_back(m_data->fuzzyColor(i));
+    // snapshot the original colours so we can restore them if the run is cancelled or if the user clicks undo
+    m_originalColors = m_data->colorSnapshot();
     ClusterMethodWidget * c = static_cast<ClusterMethodWidget*>(m_stackedWidget->currentWidget());
     m_launchWidget->setProperties(c->canCancel(), c->providesProgressUpdates());
     c->run();
@@ -120,13 +117,10 @@ void ClusteringWidget::cancel()
     ClusterMethodWidget * c = static_cast<ClusterMethodWidget*>(m_stackedWidget->currentWidget());
     c->cancel();
 
-    // restore original colours
-    size_t pos = 0;
-    for (size_t i = 0; i < m_data->points().size(); ++i) {
-        if (m_data->isSelected(i)) {
-            m_data->setColor(i, m_originalColors[pos]);
-            ++pos;
-        }
+    // restore original colours, only droplets in chunks written since the snapshot can differ
+    for (auto i : m_originalColors.changedIndices()) {
+        if (m_data->isSelected(i) && m_data->fuzzyColor(i) != m_originalColors[i])
+            m_data->setColor(i, m_originalColors[i]);
     }
 }
 
@@ -3,6 +3,7 @@
 
 #include <QWidget>
 #include "generic/command.h"
+#include "../core/data.h"
 #include "../core/fuzzycolor.h"
 
 class StackedWidget;
@@ -46,7 +47,7 @@ private:
     PaintingWidget * m_painting;
     DropletGraphWidget * m_graph;
     CommandStack * m_commandStack;
-    std::vector<FuzzyColor> m_originalColors;
+    Data::ColorSnapshot m_originalColors;
 };
 
 #endif // FUZZYDROPLETS_GUI_CLUSTERINGWIDGET_H
@@ -110,10 +110,7 @@ void DBScanWorker::proceed()
         }
         std::sort(clusterSizes.begin(), clusterSizes.end(), [](const auto & left, const auto & right){return left.second > right.second;});
 
-        for (size_t i = 0; i < m_data->pointCount(); ++i) {
-            if (m_data->isSelected(i))
-                m_data->setColor(i, 0);
-        }
+        m_data->selectionFilter().forEach([&](size_t i) {m_data->setColor(i, 0);});
         size_t colorId = 1;
         for (size_t i = 0; i < std::min(clusterSizes.size(), m_data->colorComponentCount() - 1); ++i) {
             for (size_t k = 0; k  < m_assignment.size(); ++k) {
@@ -8,6 +8,7 @@
 #include <QContextMenuEvent>
 #include <QMenu>
 #include <QPainter>
+#include <QRegion>
 #include <QSettings>
 #include <execution>
 
@@ -19,7 +20,8 @@ DropletGraphWidget::DropletGraphWidget(Data * data, CommandStack * cmdStack, QWi
     : ScatterPlotBox2(parent),
      m_data(data),
     m_commandStack(cmdStack),
-    m_cloud(new PointCloud(data, horizontalAxis(), verticalAxis()))
+    m_cloud(new PointCloud(data, horizontalAxis(), verticalAxis())),
+    m_hulls(data)
 {
     setMouseTracking(true);
     setFocusPolicy(Qt::StrongFocus);
@@ -56,11 +58,15 @@ DropletGraphWidget::DropletGraphWidget(Data * data, CommandStack * cmdStack, QWi
 
     m_cloud->setScaleFactor(settings.value("graphWidgetScaleFactor", true).toBool() ? 0.15 : 0);
     m_cloud->setBaseSize(settings.value("graphWidgetMarkerSize", 3).toDouble());
+    m_cloud->setDensityShading(static_cast<PointCloud::DensityShading>(settings.value("graphWidgetDensityShading", PointCloud::NoDensityShading).toInt()));
     addStaticPrimitive(m_cloud);
 
     connect(m_data, &Data::samplesAdded, this, &DropletGraphWidget::samplesAdded);
     connect(m_data, &Data::selectedSamplesChanged, this, &DropletGraphWidget::selectedSamplesChanged);
-    connect(m_data, &Data::fullRepaint, this, &DropletGraphWidget::repaintEntireGraph);
+    connect(m_data, &Data::fullRepaint, this, &DropletGraphWidget::colorsChanged);
+    connect(m_data, &Data::storageAboutToChange, m_cloud, &PointCloud::stopRendering);
+    connect(m_data, &Data::colorsAboutToChange, m_cloud, &PointCloud::stopRendering);
+    connect(m_cloud, &PointCloud::tilesRendered, this, &DropletGraphWidget::tilesRendered);
     connect(m_data, &Data::colorZOrderChanged, this, &DropletGraphWidget::repaintEntireGraph);
     connect(m_data, &Data::colorCountChanged, this, &DropletGraphWidget::updateConvexHullCount);
     connect(m_data, &Data::colorCountChanged, this, &DropletGraphWidget::updateConvexHullColors);
@@ -78,6 +84,7 @@ void DropletGraphWidget::samplesAdded()
 
 void DropletGraphWidget::selectedSamplesChanged()
 {
+    m_hulls.reset();
     updateStaticPrimitives();
     updateConvexHulls();
     update();
@@ -85,10 +92,38 @@ void DropletGraphWidget::selectedSamplesChanged()
 
 void DropletGraphWidget::repaintEntireGraph()
 {
+    m_data->colorChangesSince(m_colorRevision);
     updateStaticPrimitives();
     update();
 }
 
+// redraws only the screen areas of the colour grid cells that were recoloured since the last redraw
+void DropletGraphWidget::colorsChanged()
+{
+    // density shading draws the whole view on any redraw, so one full redraw replaces the per cell ones
+    auto changes = m_data->colorChangesSince(m_colorRevision);
+    if (changes.all || changes.cells.size() * 4 > Data::ColorGridSize * Data::ColorGridSize || m_cloud->densityShading() != PointCloud::NoDensityShading) {
+        updateStaticPrimitives();
+    } else {
+        auto viewport = viewportRect();
+        int margin = std::ceil(m_cloud->maxMarkerSize());
+        QRegion region;
+        for (const auto & cell : changes.cells) {
+            QRectF rect(QPointF(horizontalAxis()->pixel(cell.left()), verticalAxis()->pixel(cell.top())), QPointF(horizontalAxis()->pixel(cell.right()), verticalAxis()->pixel(cell.bottom())));
+            region += rect.normalized().translated(viewport.topLeft()).toAlignedRect().adjusted(-margin, -margin, margin, margin).intersected(viewport.toAlignedRect());
+        }
+        for (const auto & rect : region)
+            updateStaticPrimitives(rect);
+    }
+    update();
+}
+
+void DropletGraphWidget::tilesRendered()
+{
+    redrawStaticPrimitives();
+    update();
+}
+
 size_t DropletGraphWidget::markerFromMousePos(const QPoint & pos) const
 {
     auto viewport = viewportRect();
@@ -186,11 +221,14 @@ void DropletGraphWidget::SetZOrderCommand::undo()
 
 void DropletGraphWidget::parallelWorkStarted()
 {
+    // the workers write colours while they run, so no full tiles are rendered in the background meanwhile
+    m_cloud->setRenderingPaused(true);
     setEnabled(false);
 }
 
 void DropletGraphWidget::parallelWorkFinished()
 {
+    m_cloud->setRenderingPaused(false);
     setEnabled(true);
 }
 
@@ -246,24 +284,15 @@ void DropletGraphWidget::updateConvexHulls()
 {
     if (m_paintConvexHulls) {
         if (m_data->selectedPointCount() > 0) {
-            double limit = 1.0 / m_data->colorComponentCount();
-            QList<int> io(m_convexHulls.size());
-            std::iota(io.begin(), io.end(), 1);
-#ifndef Q_OS_MACOS
-            std::for_each(std::execution::par, io.begin(), io.end(), [&](int i) {
-#else
-            QtConcurrent::blockingMap(io.begin(), io.end(), [&](int i) {
-#endif
-                std::vector<Point> cols;
-                for (auto j = 0; j < m_data->points().size(); ++j)
-                    if (m_data->isSelected(j) && m_data->fuzzyColor(j).weight(i) >= limit)
-                        cols.push_back(m_data->point(j));
-                auto poly = Polygon::convexHull(cols);
+            m_hulls.update();
+            for (qsizetype i = 0; i < m_convexHulls.size(); ++i) {
                 QPolygonF qp;
-                for (const auto & point : poly.points())
-                    qp << QPointF(point.x(), point.y());
-                m_convexHulls[i - 1]->setPolygon(qp);
-            });
+                if (size_t(i + 1) < m_hulls.hullCount()) {
+                    for (const auto & point : m_hulls.hull(i + 1))
+                        qp << QPointF(point.x(), point.y());
+                }
+                m_convexHulls[i]->setPolygon(qp);
+            }
         } else {
             for (auto & p : m_convexHulls) {
                 p->setPolygon(QPolygonF());
@@ -287,3 +316,12 @@ void DropletGraphWidget::setScaleFactor(double d)
     updateStaticPrimitives();
     update();
 }
+
+void DropletGraphWidget::setDensityShading(int shading)
+{
+    QSettings settings;
+    settings.setValue("graphWidgetDensityShading", shading);
+    m_cloud->setDensityShading(static_cast<PointCloud::DensityShading>(shading));
+    updateStaticPrimitives();
+    update();
+}
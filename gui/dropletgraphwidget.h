@@ -3,6 +3,7 @@
 
 #include "plot/scatterplotbox2.h"
 #include "generic/command.h"
+#include "../core/componenthulls.h"
 
 class Data;
 class PointCloud;
@@ -54,6 +55,8 @@ public slots:
     void samplesAdded();
     void selectedSamplesChanged();
     void repaintEntireGraph();
+    void colorsChanged();
+    void tilesRendered();
     void parallelWorkStarted();
     void parallelWorkFinished();
     void setConvexHullsVisible(bool);
@@ -62,6 +65,7 @@ public slots:
     void updateConvexHulls();
     void setMarkerSize(int);
     void setScaleFactor(double d);
+    void setDensityShading(int shading);
 
 private:
 
@@ -70,8 +74,10 @@ private:
     Data * m_data;
     CommandStack * m_commandStack;
     PointCloud * m_cloud;
+    size_t m_colorRevision {0};
     bool m_paintConvexHulls {false};
     QList<Plot::Polygon*> m_convexHulls;
+    ComponentHulls m_hulls;
 
 };
 
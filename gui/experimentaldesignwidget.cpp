@@ -601,7 +601,7 @@ ExperimentalDesignWizard::SetDesignCommand::SetDesignCommand(Data * data, Painti
     for (size_t i = 1; i < m_data->colorComponentCount(); ++i) {
         m_oldColors.push_back(m_data->colorScheme()->color(i));
     }
-    m_oldFuzzies = m_data->fuzzyColors();
+    m_oldFuzzies = m_data->colorSnapshot();
 }
 
 void ExperimentalDesignWizard::SetDesignCommand::redo()
@@ -620,7 +620,8 @@ void ExperimentalDesignWizard::SetDesignCommand::undo()
     }
     m_data->setDesign(m_oldDesign);
     m_data->setColorComponentCount(m_oldColors.size()+1);
-    for (size_t i = 0; i < m_data->pointCount(); ++i) {
+    emit m_data->colorsAboutToChange();
+    for (auto i : m_oldFuzzies.changedIndices()) {
         m_data->setColor(i, m_oldFuzzies[i]);
     }
     m_painting->beginPaintOperation();
@@ -715,6 +716,9 @@ void ExperimentalDesignWidget::startPositioningCentroids()
     m_pointCloud = new PointCloud(m_data, horizontalAxis(), verticalAxis());
     m_pointCloud->setBaseSize(m_graph->pointCloud()->baseSize());
     m_pointCloud->setQuadTree(m_data->quadTree());
+    connect(m_data, &Data::storageAboutToChange, m_pointCloud, &PointCloud::stopRendering);
+    connect(m_data, &Data::colorsAboutToChange, m_pointCloud, &PointCloud::stopRendering);
+    connect(m_pointCloud, &PointCloud::tilesRendered, this, [this]() {redrawStaticPrimitives(); update();});
     addStaticPrimitive(m_pointCloud);
     if (m_data->design()->clusterCount() == m_design.clusterCount()) {
         m_design.setClusterCentroids(m_data->design()->clusterCentroids());
@@ -7,6 +7,7 @@
 #include "../core/design.h"
 #include "plot/ringmarker.h"
 #include "generic/commandstack.h"
+#include "../core/data.h"
 #include "../core/fuzzycolor.h"
 
 class QFormLayout;
@@ -49,7 +50,7 @@ public:
         Design m_oldDesign;
         QList<QColor> m_newColors;
         QList<QColor> m_oldColors;
-        std::vector<FuzzyColor> m_oldFuzzies;
+        Data::ColorSnapshot m_oldFuzzies;
     };
 
     enum Staggering
@@ -1,6 +1,8 @@
 #ifndef FUZZYDROPLETS_GUI_GENERIC_COMMAND_H
 #define FUZZYDROPLETS_GUI_GENERIC_COMMAND_H
 
+#include <cstddef>
+
 class BaseCommand
 {
     template <typename T> friend class Command;
@@ -12,6 +14,9 @@ public:
     virtual void redo() = 0;
     virtual void undo() = 0;
     virtual bool compressInto(BaseCommand *) const {return false;}
+    virtual size_t memoryUsage() const {return 0;}     // bytes held, counted against the stack's memory budget
+    virtual size_t diskUsage() const {return 0;}       // bytes spilled, counted against the stack's disk budget
+    virtual bool spill() {return false;}               // moves what it holds to disk, true if memory was freed
 
 private:
 
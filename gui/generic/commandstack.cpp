@@ -1,5 +1,6 @@
 #include "commandstack.h"
 #include "command.h"
+#include <numeric>
 
 bool BeginCommandSet::compressInto(BaseCommand * cmd) const
 {
@@ -89,10 +90,59 @@ void CommandStack::add(std::shared_ptr<BaseCommand> cmd, bool doIt)
         ++m_pos;
     }
 
+    enforceBudgets();
+
     if (canUndo() != u) emit undoAvailable(canUndo());
     if (canRedo() != r) emit redoAvailable(canRedo());
 }
 
+void CommandStack::setMemoryBudget(size_t bytes)
+{
+    m_memoryBudget = bytes;
+    enforceBudgets();
+}
+
+void CommandStack::setDiskBudget(size_t bytes)
+{
+    m_diskBudget = bytes;
+    enforceBudgets();
+}
+
+// spills the oldest commands until the rest fit in memory, then drops the oldest entries (whole command sets) until
+// the spilled ones fit on disk and the others in memory. The newest entry is always kept so the last action can be
+// undone.
+void CommandStack::enforceBudgets()
+{
+    auto memoryUsage = [&]() {
+        return std::accumulate(m_commands.begin(), m_commands.end(), size_t(0), [](size_t s, const auto & c) {return s + c->memoryUsage();});
+    };
+    auto diskUsage = [&]() {
+        return std::accumulate(m_commands.begin(), m_commands.end(), size_t(0), [](size_t s, const auto & c) {return s + c->diskUsage();});
+    };
+    size_t memory = memoryUsage();
+    for (qsizetype i = 0; i < m_commands.size() && memory > m_memoryBudget; ++i) {
+        if (m_commands[i]->spill())
+            memory = memoryUsage();
+    }
+    size_t disk = diskUsage();
+
+    bool u = canUndo();
+    while ((memory > m_memoryBudget || disk > m_diskBudget) && m_pos > 0) {
+        qsizetype count = 1;
+        if (m_commands.front()->id() == BeginCommandSet::ID()) {
+            while (count < m_commands.size() && m_commands[count - 1]->id() != EndCommandSet::ID())
+                ++count;
+            if (m_commands[count - 1]->id() != EndCommandSet::ID()) break;  // the set is still open
+        }
+        if (count > m_pos) break;
+        m_commands.remove(0, count);
+        m_pos -= count;
+        memory = memoryUsage();
+        disk = diskUsage();
+    }
+    if (canUndo() != u) emit undoAvailable(canUndo());
+}
+
 void CommandStack::redo()
 {
     bool r = canRedo();
@@ -49,6 +49,17 @@ public:
 
     int size() const {return m_commands.count();}
 
+    // once the commands hold more than this, the oldest are spilled to disk
+    void setMemoryBudget(size_t bytes);
+    size_t memoryBudget() const {return m_memoryBudget;}
+
+    // once the spilled commands take more than this, the oldest are dropped
+    void setDiskBudget(size_t bytes);
+    size_t diskBudget() const {return m_diskBudget;}
+
+    static const size_t DefaultMemoryBudget = size_t(512) << 20;
+    static const size_t DefaultDiskBudget = size_t(2048) << 20;
+
 public slots:
 
     void redo();
@@ -61,7 +72,11 @@ signals:
 
 private:
 
+    void enforceBudgets();
+
     int m_pos {-1};
+    size_t m_memoryBudget {DefaultMemoryBudget};
+    size_t m_diskBudget {DefaultDiskBudget};
     QList<std::shared_ptr<BaseCommand>> m_commands;
     bool m_newCommandsBlocked {false};
     bool m_inSet {false};
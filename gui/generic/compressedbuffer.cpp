@@ -0,0 +1,116 @@
+#include "compressedbuffer.h"
+#include <QFile>
+#include <QTemporaryFile>
+#include <execution>
+#include <numeric>
+#include <ranges>
+
+#ifdef Q_OS_MACOS
+#include <QtConcurrent>
+#endif
+
+CompressedBuffer::CompressedBuffer() = default;
+
+CompressedBuffer::CompressedBuffer(const QByteArray & data)
+{
+    size_t blockCount = (data.size() + BlockSize - 1) / BlockSize;
+    m_blocks.resize(blockCount);
+    m_compressedSizes.resize(blockCount);
+#ifndef Q_OS_MACOS
+    auto iota = std::ranges::views::iota((size_t)0, blockCount);
+    std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t i) {
+#else
+    QList<size_t> iota(blockCount, 0);
+    std::iota(iota.begin(), iota.end(), 0);
+    QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & i) {
+#endif
+        m_blocks[i] = qCompress(data.mid(i * BlockSize, BlockSize), 1);
+        m_compressedSizes[i] = m_blocks[i].size();
+    });
+}
+
+CompressedBuffer::CompressedBuffer(CompressedBuffer &&) = default;
+
+// a write still running into the file being replaced is waited for first
+CompressedBuffer & CompressedBuffer::operator=(CompressedBuffer && other)
+{
+    if (m_written.valid())
+        m_written.wait();
+    m_blocks = std::move(other.m_blocks);
+    m_compressedSizes = std::move(other.m_compressedSizes);
+    m_file = std::move(other.m_file);
+    m_written = std::move(other.m_written);
+    return *this;
+}
+
+CompressedBuffer::~CompressedBuffer()
+{
+    if (m_written.valid())
+        m_written.wait();
+}
+
+QByteArray CompressedBuffer::data() const
+{
+    std::vector<QByteArray> blocks;
+    if (m_file) {
+        blocks = m_written.get();
+        if (blocks.empty()) {
+            QFile file(m_file->fileName());
+            if (file.open(QIODevice::ReadOnly)) {
+                for (auto size : m_compressedSizes)
+                    blocks.push_back(file.read(size));
+            }
+        }
+    }
+    const auto & compressed = m_file ? blocks : m_blocks;
+
+    std::vector<QByteArray> uncompressed(compressed.size());
+#ifndef Q_OS_MACOS
+    std::transform(std::execution::par, compressed.begin(), compressed.end(), uncompressed.begin(), [](const QByteArray & block) {return qUncompress(block);});
+#else
+    QList<size_t> iota(compressed.size(), 0);
+    std::iota(iota.begin(), iota.end(), 0);
+    QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & i) {uncompressed[i] = qUncompress(compressed[i]);});
+#endif
+
+    QByteArray data;
+    data.reserve(std::accumulate(uncompressed.begin(), uncompressed.end(), qsizetype(0), [](qsizetype s, const QByteArray & b) {return s + b.size();}));
+    for (const auto & block : uncompressed)
+        data.append(block);
+    return data;
+}
+
+size_t CompressedBuffer::memoryUsage() const
+{
+    return std::accumulate(m_blocks.begin(), m_blocks.end(), size_t(0), [](size_t s, const QByteArray & b) {return s + b.size();});
+}
+
+size_t CompressedBuffer::diskUsage() const
+{
+    return m_file ? std::accumulate(m_compressedSizes.begin(), m_compressedSizes.end(), size_t(0)) : 0;
+}
+
+// the temporary file is only created here, the write reopens it by name and hands the blocks back if it fails
+bool CompressedBuffer::spill()
+{
+    if (m_file || m_blocks.empty()) return false;
+    auto file = std::make_unique<QTemporaryFile>();
+    if (!file->open()) return false;
+    file->close();
+
+    m_written = std::async(std::launch::async, [path = file->fileName(), blocks = std::move(m_blocks)]() mutable {
+        QFile out(path);
+        bool written = out.open(QIODevice::WriteOnly);
+        for (const auto & block : blocks) {
+            if (!written) break;
+            written = out.write(block) == block.size();
+        }
+        if (written)
+            blocks.clear();
+        return blocks;
+    }).share();
+    m_file = std::move(file);
+    m_blocks.clear();
+    m_blocks.shrink_to_fit();
+    return true;
+}
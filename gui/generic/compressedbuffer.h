@@ -0,0 +1,41 @@
+#ifndef FUZZYDROPLETS_GUI_GENERIC_COMPRESSEDBUFFER_H
+#define FUZZYDROPLETS_GUI_GENERIC_COMPRESSEDBUFFER_H
+
+#include <QByteArray>
+#include <future>
+#include <memory>
+#include <vector>
+
+class QTemporaryFile;
+
+// bytes held as blocks compressed independently (and in parallel), which can be moved out to a temporary file to
+// free the memory and are read back transparently
+class CompressedBuffer
+{
+public:
+
+    CompressedBuffer();
+    CompressedBuffer(const QByteArray & data);
+    CompressedBuffer(CompressedBuffer &&);
+    CompressedBuffer & operator=(CompressedBuffer &&);
+    ~CompressedBuffer();
+
+    QByteArray data() const;
+    size_t memoryUsage() const;     // compressed bytes in memory
+    size_t diskUsage() const;       // compressed bytes in the temporary file
+    bool isSpilled() const {return m_file != nullptr;}
+
+    // the blocks are written on a background thread, data() waits for the write to finish
+    bool spill();
+
+private:
+
+    static const qsizetype BlockSize = 1 << 20;
+
+    std::vector<QByteArray> m_blocks;           // empty once spilled
+    std::vector<qsizetype> m_compressedSizes;
+    std::unique_ptr<QTemporaryFile> m_file;     // closed between uses, so spilled buffers hold no file descriptor
+    std::shared_future<std::vector<QByteArray>> m_written;  // the blocks again if writing them failed
+};
+
+#endif // FUZZYDROPLETS_GUI_GENERIC_COMPRESSEDBUFFER_H
@@ -2,8 +2,10 @@
 #include <QFormLayout>
 #include <QThread>
 #include <QCheckBox>
+#include <QTimer>
 #include "../core/data.h"
-#include "../core/mean.h"
+#include <execution>
+#include <ranges>
 
 #ifdef Q_OS_MACOS
 #include <QtConcurrent>
@@ -12,7 +14,6 @@
 GmmAssignmentWorker::GmmAssignmentWorker(Data * data)
     : m_data(data)
 {
-    connect(this, &GmmAssignmentWorker::finishedStep, this, &GmmAssignmentWorker::nextStep, Qt::QueuedConnection);
 }
 
 GmmAssignmentWorker::~GmmAssignmentWorker()
@@ -21,110 +22,158 @@ GmmAssignmentWorker::~GmmAssignmentWorker()
 
 void GmmAssignmentWorker::go()
 {
-    m_alpha = std::vector<double>(m_data->colorComponentCount(), 0);
-    for (auto i : m_sourceIndices) {
-        for (int k = 0 ; k < m_data->colorComponentCount(); ++k)
-            m_alpha[k] += m_data->fuzzyColor(i).weight(k);
-    }
-    for (auto & a : m_alpha) {
-        a /= m_sourceIndices.size();
-    }
+    fit();
+    if (!m_cancel)
+        assign();
+    emit finished();
+}
 
-    m_distributions.resize(m_data->colorComponentCount());
-    QList<WeightedArithmeticMean<Point>> means(m_data->colorComponentCount());
-    for (auto source : m_sourceIndices) {
-        for (int k = 0; k < m_data->colorComponentCount(); ++k) {
-            means[k].add(m_data->point(source), m_data->fuzzyColor(source).weight(k));
-        }
-    }
-    for (int k = 0; k < m_data->colorComponentCount(); ++k) {
-        m_distributions[k].setMean(means[k].mean().x(), means[k].mean().y());
-    }
+void GmmAssignmentWorker::fit()
+{
+    // one parallel pass over blocks of the source ranges collects the weighted moments of every component, block
+    // partial sums are added in order so the fit does not depend on scheduling
 
-    if (m_sharedScale) {
-        WeightedArithmeticMean<double> sx;
-        WeightedArithmeticMean<double> sy;
-        for (int k = 0; k < m_data->colorComponentCount(); ++k) {
-            for (auto i : m_sourceIndices) {
-                sx.add(pow(m_distributions[k].meanX() - m_data->point(i).x(), 2), m_data->fuzzyColor(i).weight(k));
-                sy.add(pow(m_distributions[k].meanY() - m_data->point(i).y(), 2), m_data->fuzzyColor(i).weight(k));
-            }
-        }
-        for (int k = 0; k < m_data->colorComponentCount(); ++k)
-            m_distributions[k].setStdDev(sqrt(sx.mean()), sqrt(sy.mean()));
-    } else {
-        for (int k=0; k < m_data->colorComponentCount(); ++k) {
-            WeightedArithmeticMean<double> sxMean;
-            WeightedArithmeticMean<double> syMean;
-            for (auto i : m_sourceIndices) {
-                sxMean.add(pow(m_distributions[k].meanX() - m_data->point(i).x(), 2), m_data->fuzzyColor(i).weight(k));
-                syMean.add(pow(m_distributions[k].meanY() - m_data->point(i).y(), 2), m_data->fuzzyColor(i).weight(k));
+    size_t componentCount = m_data->colorComponentCount();
+    size_t sourceCount = m_sourceIndices.size();
+    Point origin = sourceCount > 0 ? m_data->point(m_sourceIndices[0]) : Point();
+    auto sourceBlocks = m_sourceIndices.blocks(BlockSize);
+    std::vector<std::vector<BinormalMoments>> partial(sourceBlocks.size(), std::vector<BinormalMoments>(componentCount, BinormalMoments(origin.x(), origin.y())));
+
+#ifndef Q_OS_MACOS
+    auto blocks = std::ranges::views::iota((size_t)0, sourceBlocks.size());
+    std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](size_t block) {
+#else
+    QList<size_t> blocks(sourceBlocks.size(), 0);
+    std::iota(blocks.begin(), blocks.end(), 0);
+    QtConcurrent::blockingMap(blocks.begin(), blocks.end(), [&](const size_t & block) {
+#endif
+        auto & moments = partial[block];
+        for (size_t i = sourceBlocks[block][0]; i < sourceBlocks[block][1]; ++i) {
+            const auto & point = m_data->point(i);
+            const auto & weights = m_data->fuzzyColor(i).weights();
+            for (size_t k = 0; k < componentCount; ++k) {
+                if (weights[k] != 0)
+                    moments[k].add(point.x(), point.y(), weights[k]);
             }
-            m_distributions[k].setStdDev(sqrt(sxMean.mean()), sqrt(syMean.mean()));
         }
+    });
+
+    std::vector<BinormalMoments> moments(componentCount, BinormalMoments(origin.x(), origin.y()));
+    for (const auto & block : partial) {
+        for (size_t k = 0; k < componentCount; ++k)
+            moments[k] += block[k];
     }
 
-    if (m_sharedRho) {
-        ArithmeticMean<double> rho;
-        for (auto i : m_sourceIndices) {
-            for (int k = 0; k < m_distributions.size(); ++k)
-                rho.add((m_data->point(i).x() - m_distributions[k].meanX()) * (m_data->point(i).y() - m_distributions[k].meanY()) * m_data->fuzzyColor(i).weight(k));
-        }
-        for (int k = 0; k < m_distributions.size(); ++k)
-            m_distributions[k].setRho(rho.mean() / (m_distributions[k].stdDevX() * m_distributions[k].stdDevY()));
-    } else {
-        for (int k = 0; k < m_distributions.size(); ++k) {
-            ArithmeticMean<double> rMean;
-            for (auto i : m_sourceIndices)
-                rMean.add((m_data->point(i).x() - m_distributions[k].meanX()) * (m_data->point(i).y() - m_distributions[k].meanY()) * m_data->fuzzyColor(i).weight(k));
-            m_distributions[k].setRho(rMean.mean()/(m_distributions[k].stdDevX() * m_distributions[k].stdDevY()));
-        }
+    m_alpha.assign(componentCount, 0);
+    m_distributions.assign(componentCount, BinormalDistribution());
+    if (sourceCount == 0)
+        return;
+
+    double totalWeight = 0;
+    double sharedVarX = 0;
+    double sharedVarY = 0;
+    double sharedCov = 0;
+    for (size_t k = 0; k < componentCount; ++k) {
+        m_alpha[k] = moments[k].weight() / sourceCount;
+        m_distributions[k].setMean(moments[k].meanX(), moments[k].meanY());
+        totalWeight += moments[k].weight();
+        sharedVarX += moments[k].weight() * moments[k].varianceX();
+        sharedVarY += moments[k].weight() * moments[k].varianceY();
+        sharedCov += moments[k].weight() * moments[k].covariance();
     }
 
-    emit finishedStep();
-}
+    for (size_t k = 0; k < componentCount; ++k) {
+        if (m_sharedScale && totalWeight > 0)
+            m_distributions[k].setStdDev(sqrt(sharedVarX / totalWeight), sqrt(sharedVarY / totalWeight));
+        else
+            m_distributions[k].setStdDev(sqrt(moments[k].varianceX()), sqrt(moments[k].varianceY()));
 
-void GmmAssignmentWorker::cancel()
-{
-    m_cancel = true;
+        // the covariance is averaged over all sources (and components if shared), not just the component's weight
+        double cov = m_sharedRho ? sharedCov / (sourceCount * componentCount) : moments[k].weight() * moments[k].covariance() / sourceCount;
+        m_distributions[k].setRho(cov / (m_distributions[k].stdDevX() * m_distributions[k].stdDevY()));
+    }
 }
 
-void GmmAssignmentWorker::nextStep()
+void GmmAssignmentWorker::assign()
 {
-    if (!m_cancel) {
-        size_t end = std::min(m_iterStart + 1000, (size_t)m_targetIndices.size());
-        auto count = m_iterStart;
+    // targets are scored a block at a time, one component at a time over structure of arrays, so the inner
+    // loops have no branches or calls other than exp and vectorise. Normalised responsibilities are written
+    // straight into the data's colors.
+
+    size_t componentCount = m_distributions.size();
+    std::vector<std::array<double, 4>> coefficients(componentCount);
+    std::vector<size_t> active;
+    for (size_t k = 0; k < componentCount; ++k) {
+        coefficients[k] = m_distributions[k].logPdfCoefficients();
+        if (m_alpha[k] > 0)
+            active.push_back(k);
+    }
+
+    auto targetBlocks = m_targetIndices.blocks(BlockSize);
+    m_progress = 0;
 
 #ifndef Q_OS_MACOS
-        std::for_each(std::execution::par, m_targetIndices.begin() + m_iterStart, m_targetIndices.begin() + end, [&](size_t target) {
+    auto blocks = std::ranges::views::iota((size_t)0, targetBlocks.size());
+    std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](size_t block) {
 #else
-        QtConcurrent::blockingMap(m_targetIndices.begin() + m_iterStart, m_targetIndices.begin() + end, [&](size_t & target) {
+    QList<size_t> blocks(targetBlocks.size(), 0);
+    std::iota(blocks.begin(), blocks.end(), 0);
+    QtConcurrent::blockingMap(blocks.begin(), blocks.end(), [&](const size_t & block) {
 #endif
-            FuzzyColor color(m_distributions.size());
-            for (int i = 0; i < m_distributions.size(); ++i) {
-                if (m_alpha[i] > 0) {
-                    color.setWeight(i, m_distributions[i].pdf(m_data->point(target).x(), m_data->point(target).y()));
-                }
+        if (m_cancel)
+            return;
+        size_t begin = targetBlocks[block][0];
+        size_t n = targetBlocks[block][1] - begin;
+
+        std::array<double, BlockSize> x;
+        std::array<double, BlockSize> y;
+        for (size_t j = 0; j < n; ++j) {
+            const auto & point = m_data->point(begin + j);
+            x[j] = point.x();
+            y[j] = point.y();
+        }
+
+        std::vector<double> pdf(componentCount * BlockSize, 0.0);
+        for (auto k : active) {
+            const auto & c = coefficients[k];
+            double ux = m_distributions[k].meanX();
+            double uy = m_distributions[k].meanY();
+            double * out = pdf.data() + k * BlockSize;
+            for (size_t j = 0; j < n; ++j) {
+                double dx = x[j] - ux;
+                double dy = y[j] - uy;
+                out[j] = std::exp(c[0] + c[1] * dx * dx + c[2] * dx * dy + c[3] * dy * dy);
             }
-            if (color.totalWeight() > 0) {
-                color.normalize();
-            } else {
-                color.setWeight(0, 1);
+        }
+
+        std::vector<double> weights(n * componentCount);
+        for (size_t j = 0; j < n; ++j) {
+            double * w = weights.data() + j * componentCount;
+            double total = 0;
+            for (size_t k = 0; k < componentCount; ++k) {
+                w[k] = pdf[k * BlockSize + j];
+                total += w[k];
             }
-            m_data->setColor(target, color);
-            ++count;
-            double PC = 100 * count / m_targetIndices.size();
-            if (PC > m_percent) {
-                m_percent = PC;
-                emit updateProgress(m_percent);
+            if (total > 0) {
+                for (size_t k = 0; k < componentCount; ++k)
+                    w[k] /= total;
+            } else {
+                w[0] = 1;
             }
-        });
-    }
-    m_iterStart += 1000;
-    if (!m_cancel && m_iterStart < (size_t)m_targetIndices.size())
-        emit finishedStep();
-    else
-        emit finished();
+        }
+        m_data->setColorWeights(begin, begin + n, weights.data());
+        m_progress += n;
+    });
+}
+
+int GmmAssignmentWorker::progress() const
+{
+    return m_targetIndices.empty() ? 100 : int(100 * m_progress / m_targetIndices.size());
+}
+
+void GmmAssignmentWorker::cancel()
+{
+    m_cancel = true;
 }
 
 GmmAssignmentWidget::GmmAssignmentWidget(Data * data, QWidget * parent)
@@ -137,23 +186,27 @@ GmmAssignmentWidget::GmmAssignmentWidget(Data * data, QWidget * parent)
     form->addRow("Shared Scale", m_sharedScaleCB);
     form->addRow("Shared Correlation Coefficient", m_sharedRhoCB);
     setLayout(form);
+
+    m_progressTimer = new QTimer(this);
+    m_progressTimer->setInterval(100);
+    connect(m_progressTimer, &QTimer::timeout, this, &GmmAssignmentWidget::pollProgress);
 }
 
-void GmmAssignmentWidget::run(const QList<size_t> & sourceIndices, const QList<size_t> & targetIndices)
+void GmmAssignmentWidget::run(const IndexRanges & sourceIndices, const IndexRanges & targetIndices)
 {
     if (!assignmentWorkerThread) {
         emit beginAssignment();
         setEnabled(false);
         assignmentWorkerThread = new QThread;
-        GmmAssignmentWorker * worker = new GmmAssignmentWorker(m_data);
-        worker->setParams(m_sharedScaleCB->isChecked(), m_sharedRhoCB->isChecked(), sourceIndices, targetIndices);
-        worker->moveToThread(assignmentWorkerThread);
-        connect(this, &GmmAssignmentWidget::startAssignment, worker, &GmmAssignmentWorker::go);
-        connect(worker, &GmmAssignmentWorker::finished, this, &GmmAssignmentWidget::assignmentThreadFinished);
-        connect(worker, &GmmAssignmentWorker::updateProgress, this, &GmmAssignmentWidget::updateProgress);
-        connect(assignmentWorkerThread, &QThread::finished, worker, &QObject::deleteLater);
-        connect(this, &GmmAssignmentWidget::cancelAssignment, worker, &GmmAssignmentWorker::cancel);
+        m_worker = new GmmAssignmentWorker(m_data);
+        m_worker->setParams(m_sharedScaleCB->isChecked(), m_sharedRhoCB->isChecked(), sourceIndices, targetIndices);
+        m_worker->moveToThread(assignmentWorkerThread);
+        connect(this, &GmmAssignmentWidget::startAssignment, m_worker, &GmmAssignmentWorker::go);
+        connect(m_worker, &GmmAssignmentWorker::finished, this, &GmmAssignmentWidget::assignmentThreadFinished);
+        connect(assignmentWorkerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+        connect(this, &GmmAssignmentWidget::cancelAssignment, m_worker, &GmmAssignmentWorker::cancel, Qt::DirectConnection);
         assignmentWorkerThread->start();
+        m_progressTimer->start();
         emit startAssignment();
     }
 }
@@ -164,9 +217,18 @@ void GmmAssignmentWidget::cancel()
     assignmentThreadFinished();
 }
 
+void GmmAssignmentWidget::pollProgress()
+{
+    if (m_worker)
+        emit updateProgress(m_worker->progress());
+}
+
 void GmmAssignmentWidget::assignmentThreadFinished()
 {
     if (assignmentWorkerThread) {
+        m_progressTimer->stop();
+        pollProgress();
+        m_worker = nullptr;
         assignmentWorkerThread->quit();
         assignmentWorkerThread->wait();
         assignmentWorkerThread->deleteLater();
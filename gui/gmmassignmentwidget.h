@@ -3,9 +3,11 @@
 
 #include "assignmentmethodwidget.h"
 #include "../core/binormal.h"
+#include <atomic>
 
 class Data;
 class QCheckBox;
+class QTimer;
 
 class GmmAssignmentWorker : public QObject
 {
@@ -17,27 +19,26 @@ public:
     ~GmmAssignmentWorker();
 
     void go();
-    void cancel();
-    void setParams(bool sharedScale, bool sharedRho, const QList<size_t> & source, const QList<size_t> & target) {m_sharedScale = sharedScale; m_sharedRho = sharedRho; m_sourceIndices = source; m_targetIndices = target;}
+    void cancel();                  // thread safe, connect directly
+    int progress() const;           // thread safe, percentage of targets assigned
+    void setParams(bool sharedScale, bool sharedRho, const IndexRanges & source, const IndexRanges & target) {m_sharedScale = sharedScale; m_sharedRho = sharedRho; m_sourceIndices = source; m_targetIndices = target;}
 
 signals:
 
     void finished();
-    void updateProgress(int);
-    void finishedStep();
 
-public slots:
+private:
 
-    void nextStep();
+    void fit();
+    void assign();
 
-private:
+    static const size_t BlockSize = 1024;
 
     Data * m_data;
-    QList<size_t> m_sourceIndices;
-    QList<size_t> m_targetIndices;
-    size_t m_iterStart {0};
-    int m_percent {0};
-    bool m_cancel {false};
+    IndexRanges m_sourceIndices;
+    IndexRanges m_targetIndices;
+    std::atomic<size_t> m_progress {0};
+    std::atomic<bool> m_cancel {false};
     bool m_sharedScale {false};
     bool m_sharedRho {false};
     std::vector<BinormalDistribution> m_distributions;
@@ -54,7 +55,7 @@ public:
 
     virtual bool providesProgressUpdates() const {return true;}
     virtual bool canCancel() const {return true;}
-    virtual void run(const QList<size_t> & sourceIndices, const QList<size_t> & targetIndices);
+    virtual void run(const IndexRanges & sourceIndices, const IndexRanges & targetIndices);
     virtual void cancel();
 
 signals:
@@ -65,10 +66,16 @@ public slots:
 
     void assignmentThreadFinished();
 
+private slots:
+
+    void pollProgress();
+
 private:
 
     Data * m_data;
     QThread * assignmentWorkerThread {nullptr};
+    GmmAssignmentWorker * m_worker {nullptr};
+    QTimer * m_progressTimer;
     QCheckBox * m_sharedScaleCB;
     QCheckBox * m_sharedRhoCB;
 };
@@ -43,6 +43,8 @@ MainWindow::MainWindow(QWidget *parent)
     m_commandStack(new CommandStack(this))
 {
     setMouseTracking(true);
+    m_commandStack->setMemoryBudget(QSettings().value("undoMemoryBudgetMB", qulonglong(CommandStack::DefaultMemoryBudget >> 20)).toULongLong() << 20);
+    m_commandStack->setDiskBudget(QSettings().value("undoDiskBudgetMB", qulonglong(CommandStack::DefaultDiskBudget >> 20)).toULongLong() << 20);
     resize(qGuiApp->primaryScreen()->size().width() * 0.75, qGuiApp->primaryScreen()->size().height() * 0.6);
 
     m_sampleListWidget = new SampleListWidget(m_data, m_commandStack, this);
@@ -90,6 +92,8 @@ MainWindow::MainWindow(QWidget *parent)
     m_exportImageMenu = fileMenu->addMenu(themedIcon(":/image"), "Export Image");
     m_exportImageMenu->addAction("Export JPEG...", this, &MainWindow::exportJPG);
     m_exportImageMenu->addAction("Export TIFF...", this, &MainWindow::exportTIFF);
+    m_exportImageMenu->addAction("Export SVG...", this, &MainWindow::exportSVG);
+    m_exportImageMenu->addAction("Export PDF...", this, &MainWindow::exportPDF);
     m_exportImageMenu->setEnabled(false);
     fileMenu->addSeparator();
     m_exportReportAction = fileMenu->addAction(themedIcon(":/exportReport"), "Export Assignment Report...", this, &MainWindow::exportReport);
@@ -181,6 +185,18 @@ MainWindow::MainWindow(QWidget *parent)
         z2->setChecked(true);
     }
 
+    auto densityMenu = markersMenu->addMenu("Density When Overplotted");
+    auto d1 = densityMenu->addAction("Draw Markers"); d1->setCheckable(true); d1->setData(PointCloud::NoDensityShading);
+    auto d2 = densityMenu->addAction("Logarithmic Density"); d2->setCheckable(true); d2->setData(PointCloud::LogDensityShading);
+    auto d3 = densityMenu->addAction("Equalised Density"); d3->setCheckable(true); d3->setData(PointCloud::EqualisedDensityShading);
+    QActionGroup * densityGroup = new QActionGroup(this);
+    densityGroup->addAction(d1);
+    densityGroup->addAction(d2);
+    densityGroup->addAction(d3);
+    for (auto action : densityGroup->actions())
+        action->setChecked(action->data().toInt() == m_graphWidget->pointCloud()->densityShading());
+    connect(densityGroup, &QActionGroup::triggered, this, [this](QAction * action) {m_graphWidget->setDensityShading(action->data().toInt());});
+
     auto helpMenu = menuBar()->addMenu("Help");
     helpMenu->addAction("How to Cite...", this, &MainWindow::citation);
     helpMenu->addSeparator();
@@ -730,6 +746,75 @@ void MainWindow::exportTIFF()
     }
 }
 
+void MainWindow::exportSVG()
+{
+    QSettings settings;
+    auto output = QFileDialog::getSaveFileName(this, "", settings.value("exportDir", QDir::homePath()).toString(), "SVG Files (*.svg)");
+    if (!output.isEmpty()) {
+
+        QDialog d;
+        QVBoxLayout * mainLayout = new QVBoxLayout;
+        d.setLayout(mainLayout);
+
+        QFormLayout * layout = new QFormLayout;
+        QComboBox * markers = new QComboBox;
+        markers->addItem(themedIcon(":/square"), "Square", 0);
+        markers->addItem(themedIcon(":/circle"), "Circle", 1);
+        markers->setCurrentIndex(settings.value("svgMarkerShape", 1).toInt());
+        layout->addRow("Marker Shape", markers);
+
+        mainLayout->addLayout(layout);
+        auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok);
+        mainLayout->addWidget(buttonBox);
+        connect(buttonBox, &QDialogButtonBox::accepted, &d, &QDialog::accept);
+
+        if (d.exec() == QDialog::Accepted) {
+            settings.setValue("svgMarkerShape", markers->currentIndex());
+            m_graphWidget->pointCloud()->setRoundSvgMarkers(markers->currentIndex() == 1);
+            QFileInfo fi(output);
+            settings.setValue("exportDir", fi.absolutePath());
+            m_graphWidget->writeSvg(output);
+        }
+    }
+}
+
+void MainWindow::exportPDF()
+{
+    QSettings settings;
+    auto output = QFileDialog::getSaveFileName(this, "", settings.value("exportDir", QDir::homePath()).toString(), "PDF Files (*.pdf)");
+    if (!output.isEmpty()) {
+
+        QDialog d;
+        QVBoxLayout * mainLayout = new QVBoxLayout;
+        d.setLayout(mainLayout);
+
+        QFormLayout * layout = new QFormLayout;
+        QComboBox * markers = new QComboBox;
+        markers->addItem(themedIcon(":/square"), "Square", 0);
+        markers->addItem(themedIcon(":/circle"), "Circle", 1);
+        markers->setCurrentIndex(settings.value("pdfMarkerShape", 1).toInt());
+        layout->addRow("Marker Shape", markers);
+        QSpinBox * dpiEdit = new QSpinBox;
+        dpiEdit->setRange(72, 1200);
+        dpiEdit->setValue(settings.value("pdfDpi", 300).toInt());
+        layout->addRow("Dots per Inch", dpiEdit);
+
+        mainLayout->addLayout(layout);
+        auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok);
+        mainLayout->addWidget(buttonBox);
+        connect(buttonBox, &QDialogButtonBox::accepted, &d, &QDialog::accept);
+
+        if (d.exec() == QDialog::Accepted) {
+            settings.setValue("pdfMarkerShape", markers->currentIndex());
+            settings.setValue("pdfDpi", dpiEdit->value());
+            m_graphWidget->pointCloud()->setRoundSvgMarkers(markers->currentIndex() == 1);
+            QFileInfo fi(output);
+            settings.setValue("exportDir", fi.absolutePath());
+            m_graphWidget->writePdf(output, dpiEdit->value());
+        }
+    }
+}
+
 void MainWindow::exportReport()
 {
     if (m_data->design()->clusterCount() == 0) {
@@ -74,6 +74,8 @@ private:
     void processFileLoadErrorMessage(const std::string & error);
     void setAxisComponentVisibility(QString name, Plot::Axis * axis, Plot::Axis::Component component, bool visible);
     void exportTIFF();
+    void exportSVG();
+    void exportPDF();
 
     Data * m_data;
     CommandStack * m_commandStack {nullptr};
@@ -4,6 +4,8 @@
 #include <QCheckBox>
 #include <QThread>
 #include "../core/data.h"
+#include <execution>
+#include <ranges>
 
 #ifdef Q_OS_MACOS
 #include <QtConcurrent>
@@ -22,7 +24,11 @@ NearestNeighboursWorker::~NearestNeighboursWorker()
 
 void NearestNeighboursWorker::go()
 {
-    m_tree = new QuadTree<size_t>(m_sourceIndices, [&](size_t i){return m_data->point(i).x();}, [&](size_t i){return m_data->point(i).y();});
+    // the tree looks sources up by position, so they are laid out flat once; targets are worked through in
+    // contiguous blocks of the ranges
+    m_sources.assign(m_sourceIndices.begin(), m_sourceIndices.end());
+    m_targetBlocks = m_targetIndices.blocks(1000);
+    m_tree = new QuadTree<size_t>(m_sources, [&](size_t i){return m_data->point(i).x();}, [&](size_t i){return m_data->point(i).y();});
     emit finishedStep();
 }
 
@@ -33,38 +39,41 @@ void NearestNeighboursWorker::cancel()
 
 void NearestNeighboursWorker::nextStep()
 {
-    if (!m_cancel) {
-        size_t end = std::min(m_iterStart + 1000, (size_t)m_targetIndices.size());
-        int count = m_iterStart;
+    if (!m_cancel && m_block < m_targetBlocks.size()) {
+        const auto & block = m_targetBlocks[m_block];
 
 #ifndef Q_OS_MACOS
-        std::for_each(std::execution::par, m_targetIndices.begin() + m_iterStart, m_targetIndices.begin() + end, [&](size_t target) {
+        auto targets = std::ranges::views::iota(block[0], block[1]);
+        std::for_each(std::execution::par, targets.begin(), targets.end(), [&](size_t target) {
 #else
-        QtConcurrent::blockingMap(m_targetIndices.begin() + m_iterStart, m_targetIndices.begin() + end, [&](size_t & target) {
+        QList<size_t> targets(block[1] - block[0], 0);
+        std::iota(targets.begin(), targets.end(), block[0]);
+        QtConcurrent::blockingMap(targets.begin(), targets.end(), [&](const size_t & target) {
 #endif
-            auto points = m_tree->kNearestNeighbors(m_sourceIndices, m_k, m_data->point(target).x(), m_data->point(target).y());
+            auto points = m_tree->kNearestNeighbors(m_sources, m_k, m_data->point(target).x(), m_data->point(target).y());
             FuzzyColor color(m_data->colorComponentCount());
             for (auto point : points) {
                 for (int i = 0; i < m_data->colorComponentCount(); ++i) {
                     if (m_weighted) {
-                        color.setWeight(i, color.weight(i) + m_data->fuzzyColor(m_sourceIndices[point.first]).weight(i) * 1.0/(m_data->point(m_sourceIndices[point.first]).squaredDistanceTo(m_data->point(target))));
+                        color.setWeight(i, color.weight(i) + m_data->fuzzyColor(m_sources[point.first]).weight(i) * 1.0/(m_data->point(m_sources[point.first]).squaredDistanceTo(m_data->point(target))));
                     } else {
-                        color.setWeight(i, color.weight(i) + m_data->fuzzyColor(m_sourceIndices[point.first]).weight(i));
+                        color.setWeight(i, color.weight(i) + m_data->fuzzyColor(m_sources[point.first]).weight(i));
                     }
                 }
             }
             color.normalize();
             m_data->setColor(target, color);
-            ++count;
-            double PC = 100 * count / m_targetIndices.size();
-            if (PC > m_percent) {
-                m_percent = PC;
-                emit updateProgress(m_percent);
-            }
         });
+
+        m_count += block[1] - block[0];
+        int PC = 100 * m_count / m_targetIndices.size();
+        if (PC > m_percent) {
+            m_percent = PC;
+            emit updateProgress(m_percent);
+        }
     }
-    m_iterStart += 1000;
-    if (!m_cancel && m_iterStart < (size_t)m_targetIndices.size())
+    ++m_block;
+    if (!m_cancel && m_block < m_targetBlocks.size())
         emit finishedStep();
     else
         emit finished();
@@ -85,7 +94,7 @@ NearestNeighboursWidget::NearestNeighboursWidget(Data * data, QWidget * parent)
     setLayout(form);
 }
 
-void NearestNeighboursWidget::run(const QList<size_t> & sourceIndices, const QList<size_t> & targetIndices)
+void NearestNeighboursWidget::run(const IndexRanges & sourceIndices, const IndexRanges & targetIndices)
 {
     if (!assignmentWorkerThread) {
         emit beginAssignment();
@@ -16,7 +16,7 @@ public:
     NearestNeighboursWorker(Data * data);
     ~NearestNeighboursWorker();
 
-    void setParams(int k, bool weighted, const QList<size_t> & source, const QList<size_t> & target) {m_k = k; m_weighted = weighted; m_sourceIndices = source; m_targetIndices = target;}
+    void setParams(int k, bool weighted, const IndexRanges & source, const IndexRanges & target) {m_k = k; m_weighted = weighted; m_sourceIndices = source; m_targetIndices = target;}
     void go();
     void cancel();
 
@@ -35,9 +35,12 @@ private:
     Data * m_data;
     int m_k;
     bool m_weighted;
-    QList<size_t> m_sourceIndices;
-    QList<size_t> m_targetIndices;
-    size_t m_iterStart {0};
+    IndexRanges m_sourceIndices;
+    IndexRanges m_targetIndices;
+    std::vector<size_t> m_sources;
+    std::vector<IndexRanges::Range> m_targetBlocks;
+    size_t m_block {0};
+    size_t m_count {0};
     int m_percent {0};
     QuadTree<size_t> * m_tree;
     bool m_cancel {false};
@@ -53,7 +56,7 @@ public:
 
     virtual bool providesProgressUpdates() const {return true;}
     virtual bool canCancel() const {return true;}
-    virtual void run(const QList<size_t> & sourceIndices, const QList<size_t> & targetIndices);
+    virtual void run(const IndexRanges & sourceIndices, const IndexRanges & targetIndices);
     virtual void cancel();
 
 signals:
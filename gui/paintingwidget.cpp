@@ -7,6 +7,8 @@
 #include "../core/data.h"
 #include "../core/colorscheme.h"
 #include "../core/kernel.h"
+#include "../core/boxblur.h"
+#include "../core/kernelsmoothing.h"
 
 #include <QBoxLayout>
 #include <QGroupBox>
@@ -18,7 +20,10 @@
 #include <QGridLayout>
 
 #include <atomic>
+#include <bit>
+#include <cstring>
 #include <execution>
+#include <ranges>
 
 #include <QProgressBar>
 #include <QCheckBox>
@@ -28,6 +33,7 @@
 #include <QComboBox>
 #include <QToolTip>
 #include <QThread>
+#include <QTimer>
 #include <QGuiApplication>
 #include <QStyleHints>
 
@@ -50,6 +56,11 @@ PaintingWidget::PaintingWidget(Data * data, CommandStack * cmdStack, DropletGrap
     connect(data, &Data::designChanged, this, &PaintingWidget::updatePaletteWidgets);
     connect(data, &Data::samplesAdded, this, &PaintingWidget::samplesAdded);
 
+    m_strokeTimer = new QTimer(this);
+    m_strokeTimer->setSingleShot(true);
+    m_strokeTimer->setInterval(StrokeInterval);
+    connect(m_strokeTimer, &QTimer::timeout, this, &PaintingWidget::applyPendingStroke);
+
     m_paletteLayout = new FlowLayout;
     paletteWidget->setLayout(m_paletteLayout);
     topLevelLayout->addWidget(paletteWidget);
@@ -88,8 +99,11 @@ PaintingWidget::PaintingWidget(Data * data, CommandStack * cmdStack, DropletGrap
     connect(brushSizeSlider, &QSlider::sliderReleased, this, &PaintingWidget::brushSizeSliderReleased);
     connect(brushStrengthSlider, &QSlider::valueChanged, this, &PaintingWidget::brushStrengthSliderValueChanged);
 
-    QGroupBox * boxBlurBox = new QGroupBox("Circular Box Blur", this);
+    QGroupBox * boxBlurBox = new QGroupBox("Blur", this);
     QVBoxLayout * boxBlurLayout = new QVBoxLayout;
+    m_blurKernel = new QComboBox;
+    m_blurKernel->addItems(QStringList() << "Circular Box" << "Epanechnikov" << "Quartic" << "Triweight" << "Tricube" << "Cosine" << "Gaussian");
+    boxBlurLayout->addWidget(m_blurKernel);
     m_boxBlurSlider = new QSlider(Qt::Horizontal);
     m_boxBlurSlider->setRange(20, 2000);
     m_boxBlurSlider->setValue(200);
@@ -135,6 +149,7 @@ PaintingWidget::PaintingWidget(Data * data, CommandStack * cmdStack, DropletGrap
 PaintingWidget::~PaintingWidget()
 {
     if (boxBlurWorkerThread) {
+        m_blurCancelled = true;
         boxBlurWorkerThread->quit();
         boxBlurWorkerThread->wait();
         delete boxBlurWorkerThread;
@@ -143,16 +158,14 @@ PaintingWidget::~PaintingWidget()
 
 void PaintingWidget::colorsSetProgramatically()
 {
-    size_t count = 0;
-    for (qsizetype i = 0; i < m_painted.size(); ++i) {
-        m_painted[i] = (m_data->isSelected(i) && m_data->fuzzyColor(i) != m_prevColors[i]);
-        count += m_painted[i];
-    }
-    if (count > 0) {
+    // only droplets in chunks written since the snapshot can differ from it
+    for (auto i : m_prevColors.changedIndices())
+        m_painted.set(i, m_data->isSelected(i) && m_data->fuzzyColor(i) != m_prevColors[i]);
+    if (m_painted.any()) {
         m_commandStack->add(new PaintingWidget::PaintStrokeCommand(this, m_painted, m_prevColors), false);
         if (m_graph->convexHullsVisible())
             m_graph->updateConvexHulls();
-        m_graph->repaintEntireGraph();
+        m_graph->colorsChanged();
         beginPaintOperation();
     }
 }
@@ -172,13 +185,13 @@ void PaintingWidget::deterministicallyDefuzzify()
 void PaintingWidget::clear()
 {
     size_t count = 0;
-    for (qsizetype i = 0; i < m_painted.size(); ++i) {
-        m_painted[i] = (m_data->isSelected(i) && m_data->fuzzyColor(i).weight(0) != 1);
-        if (m_painted[i]) {
+    emit m_data->colorsAboutToChange();
+    m_data->selectionFilter().forEach([&](size_t i) {
+        if (m_data->fuzzyColor(i).weight(0) != 1) {
             m_data->setColor(i, 0);
             ++count;
         }
-    }
+    });
     if (count > 0) {
         colorsSetProgramatically();
         beginPaintOperation();
@@ -187,12 +200,8 @@ void PaintingWidget::clear()
 
 void PaintingWidget::beginPaintOperation()
 {
-    m_prevColors = m_data->fuzzyColors();
-#ifdef Q_OS_MACOS
-    QtConcurrent::blockingMap(m_painted, [](bool & b) {b = false;});
-#else
-    std::fill(std::execution::par, m_painted.begin(), m_painted.end(), false);
-#endif
+    m_prevColors = m_data->colorSnapshot();
+    m_painted.fill(false);
 }
 
 void PaintingWidget::boxBlurSliderValueChanged(int value)
@@ -214,62 +223,234 @@ void PaintingWidget::boxBlurSliderReleased()
     m_graph->update();
 }
 
-PaintingWidget::PaintStrokeCommand::PaintStrokeCommand(PaintingWidget * p, const QList<bool> & painted, const std::vector<FuzzyColor> & prevColors)
-    : m_paintingWidget(p)
+// weights are stored as their exact bits, the new ones xor the old so unchanged components become zero words that
+// compress away
+PaintingWidget::PaintStrokeCommand::PaintStrokeCommand(PaintingWidget * p, const BitSet & painted, const Data::ColorSnapshot & prevColors)
+    : m_paintingWidget(p),
+    m_componentCount(p->data()->colorComponentCount())
 {
-    size_t numModified = std::count_if(
-#ifndef Q_OS_MACOS
-        std::execution::par,
-#endif
-        painted.begin(), painted.end(), [](bool b){return b;});
-    m_data.reserve(numModified);
-    for (qsizetype i = 0; i < painted.size(); ++i) {
-        if (painted[i]) {
-            m_data.push_back({i, prevColors[i], p->data()->fuzzyColor(i)});
+    std::vector<quint64> runs;
+    painted.forEachRun([&](size_t begin, size_t end) {
+        runs.push_back(begin);
+        runs.push_back(end - begin);
+        m_count += end - begin;
+    });
+
+    const size_t K = m_componentCount;
+    QByteArray record((1 + runs.size() + 2 * m_count * K) * sizeof(quint64), Qt::Uninitialized);
+    quint64 runCount = runs.size() / 2;
+    char * out = record.data();
+    std::memcpy(out, &runCount, sizeof(quint64));
+    std::memcpy(out + sizeof(quint64), runs.data(), runs.size() * sizeof(quint64));
+    char * oldWeights = out + (1 + runs.size()) * sizeof(quint64);
+    char * newWeights = oldWeights + m_count * K * sizeof(quint64);
+    size_t pos = 0;
+    for (size_t r = 0; r < runs.size(); r += 2) {
+        for (size_t i = runs[r]; i < runs[r] + runs[r + 1]; ++i, ++pos) {
+            const auto & prev = prevColors[i];
+            const auto & color = p->data()->fuzzyColor(i);
+            for (size_t k = 0; k < K; ++k) {
+                quint64 oldBits = std::bit_cast<quint64>(k < prev.componentCount() ? prev.weight(k) : 0.0);
+                quint64 newBits = std::bit_cast<quint64>(k < color.componentCount() ? color.weight(k) : 0.0) ^ oldBits;
+                std::memcpy(oldWeights + (pos * K + k) * sizeof(quint64), &oldBits, sizeof(quint64));
+                std::memcpy(newWeights + (pos * K + k) * sizeof(quint64), &newBits, sizeof(quint64));
+            }
         }
     }
+    m_record = CompressedBuffer(record);
 }
 
-void PaintingWidget::PaintStrokeCommand::redo()
+void PaintingWidget::PaintStrokeCommand::apply(bool newColors)
 {
+    const size_t K = m_componentCount;
+    QByteArray record = m_record.data();
+    const char * in = record.constData();
+    quint64 runCount;
+    std::memcpy(&runCount, in, sizeof(quint64));
+    std::vector<quint64> runs(2 * runCount);
+    std::memcpy(runs.data(), in + sizeof(quint64), runs.size() * sizeof(quint64));
+    const char * oldWeights = in + (1 + runs.size()) * sizeof(quint64);
+    const char * newWeights = oldWeights + m_count * K * sizeof(quint64);
+
+    std::vector<size_t> indices;
+    indices.reserve(m_count);
+    for (size_t r = 0; r < runs.size(); r += 2) {
+        for (size_t i = runs[r]; i < runs[r] + runs[r + 1]; ++i)
+            indices.push_back(i);
+    }
+
+    emit m_paintingWidget->data()->colorsAboutToChange();
+    auto set = [&](size_t pos) {
+        std::vector<double> weights(K);
+        for (size_t k = 0; k < K; ++k) {
+            quint64 bits;
+            std::memcpy(&bits, oldWeights + (pos * K + k) * sizeof(quint64), sizeof(quint64));
+            if (newColors) {
+                quint64 delta;
+                std::memcpy(&delta, newWeights + (pos * K + k) * sizeof(quint64), sizeof(quint64));
+                bits ^= delta;
+            }
+            weights[k] = std::bit_cast<double>(bits);
+        }
+        m_paintingWidget->data()->setColor(indices[pos], FuzzyColor(std::move(weights)));
+    };
 #ifndef Q_OS_MACOS
-    std::for_each(std::execution::par, m_data.begin(), m_data.end(), [&](auto & tuple) {
-        m_paintingWidget->data()->setColor(std::get<0>(tuple), std::get<2>(tuple));
-    });
+    auto iota = std::ranges::views::iota((size_t)0, indices.size());
+    std::for_each(std::execution::par, iota.begin(), iota.end(), set);
 #else
-    QtConcurrent::blockingMap(m_data.begin(), m_data.end(), [&](auto & tuple) {
-        m_paintingWidget->data()->setColor(std::get<0>(tuple), std::get<2>(tuple));
-    });
+    QList<size_t> iota(indices.size(), 0);
+    std::iota(iota.begin(), iota.end(), 0);
+    QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & pos) {set(pos);});
 #endif
 
     m_paintingWidget->beginPaintOperation();
     if (m_paintingWidget->graph()->convexHullsVisible())
         m_paintingWidget->graph()->updateConvexHulls();
-    m_paintingWidget->graph()->repaintEntireGraph();
+    m_paintingWidget->graph()->colorsChanged();
+}
+
+void PaintingWidget::PaintStrokeCommand::redo()
+{
+    apply(true);
 }
 
 void PaintingWidget::PaintStrokeCommand::undo()
 {
-#ifndef Q_OS_MACOS
-    std::for_each(std::execution::par, m_data.begin(), m_data.end(), [&](auto & tuple) {
-        m_paintingWidget->data()->setColor(std::get<0>(tuple), std::get<1>(tuple));
-    });
-#else
-    QtConcurrent::blockingMap(m_data.begin(), m_data.end(), [&](auto & tuple) {
-        m_paintingWidget->data()->setColor(std::get<0>(tuple), std::get<1>(tuple));
-    });
-#endif
+    apply(false);
+}
+
+namespace {
+
+double distanceToSegment(const QPointF & p, const QPointF & a, const QPointF & b)
+{
+    QPointF ab = b - a;
+    double length2 = QPointF::dotProduct(ab, ab);
+    double t = length2 > 0 ? std::clamp(QPointF::dotProduct(p - a, ab) / length2, 0.0, 1.0) : 0.0;
+    QPointF d = p - (a + t * ab);
+    return std::sqrt(QPointF::dotProduct(d, d));
+}
 
-    m_paintingWidget->beginPaintOperation();
-    if (m_paintingWidget->graph()->convexHullsVisible())
-        m_paintingWidget->graph()->updateConvexHulls();
-    m_paintingWidget->graph()->repaintEntireGraph();
+}
+
+QRect PaintingWidget::brushRect(const QPoint & pos) const
+{
+    return QRect(pos - QPoint(m_brushSize / 2 + 1, m_brushSize / 2 + 1), QSize(2 * (int)(m_brushSize / 2) + 2, 2 * (int)(m_brushSize / 2) + 2));
+}
+
+// paints the capsules the brush swept between the mouse positions gathered since the last frame in one pass, each
+// droplet once at its distance to the nearest of them. Only the area swept is redrawn.
+void PaintingWidget::applyPendingStroke()
+{
+    if (m_pendingStroke.isEmpty()) return;
+    QList<QPoint> stroke;
+    stroke.swap(m_pendingStroke);
+    if (m_paletteButtonId < 0) return;
+
+    // droplets are compared in pixels relative to the viewport
+    auto viewport = m_graph->viewportRect();
+    const auto * xAxis = m_graph->horizontalAxis();
+    const auto * yAxis = m_graph->verticalAxis();
+    const double r = m_brushSize / 2;
+    QRectF area = viewport.translated(-viewport.topLeft());
+    bool once = m_brushStrength == 100 || flatPainting->isChecked();
+
+    std::vector<std::pair<size_t, double>> items;       // droplet and its distance to the stroke over the radius
+    QList<QPointF> positions;                           // of the mouse events gathered, not the anchor
+    QRectF swept;
+    QPointF previous = m_strokeAnchor.value_or(QPointF(stroke.front()) - viewport.topLeft());
+    for (const auto & pos : stroke) {
+        QPointF a = previous;
+        QPointF b = QPointF(pos) - viewport.topLeft();
+        positions.append(b);
+        previous = b;
+        QRectF box = QRectF(a, b).normalized().adjusted(-r, -r, r, r);
+        swept |= box;
+        double x0 = xAxis->value(box.left());
+        double x1 = xAxis->value(box.right());
+        double y0 = yAxis->value(box.top());
+        double y1 = yAxis->value(box.bottom());
+        OrthogonalRectangle rect(Point(std::min(x0, x1), std::min(y0, y1)), Point(std::max(x0, x1), std::max(y0, y1)));
+        for (auto i : m_data->rectangleSearchSelection(rect, [&](size_t i) {return !once || !m_painted[i];})) {
+            QPointF p(xAxis->pixel(m_data->point(i).x()), yAxis->pixel(m_data->point(i).y()));
+            if (!area.contains(p)) continue;
+            double u = distanceToSegment(p, a, b) / r;
+            if (u < 1)
+                items.push_back({i, u});
+        }
+    }
+    m_strokeAnchor = previous;
+
+    std::ranges::sort(items);
+    items.erase(std::unique(items.begin(), items.end(), [](const auto & left, const auto & right) {return left.first == right.first;}), items.end());
+    if (items.empty()) return;
+
+    emit m_data->colorsAboutToChange();
+    if (m_brushStrength == 100) { // flat and unfuzzy painting, no feathering
+        for (auto [i, u] : items) {
+            m_data->setColor(i, m_paletteButtonId);
+            m_painted.set(i, m_data->fuzzyColor(i) != m_prevColors[i]);
+        }
+    } else if (flatPainting->isChecked()) { // flat painting, no feathering
+        double weight = (double)m_brushStrength / 100;
+        for (auto [i, u] : items) {
+            m_data->setWeightToColorComponent(i, m_paletteButtonId, weight);
+            m_painted.set(i, m_data->fuzzyColor(i) != m_prevColors[i]);
+        }
+    } else { // additive painting, feathered by the kernel chosen
+        double weight = (double)m_brushStrength / 800;
+        switch (feathered->currentIndex()) {
+        case 0: paintAdditive<UniformKernel<double>>(items, positions, weight); break;
+        case 1: paintAdditive<EpanechnikovKernel<double>>(items, positions, weight); break;
+        case 2: paintAdditive<QuarticKernel<double>>(items, positions, weight); break;
+        case 3: paintAdditive<TriWeightKernel<double>>(items, positions, weight); break;
+        case 4: paintAdditive<TricubeKernel<double>>(items, positions, weight); break;
+        default: paintAdditive<CosineKernel<double>>(items, positions, weight);
+        }
+    }
+
+    double maxSize = m_graph->pointCloud()->maxMarkerSize();
+    QRectF dirty = swept.translated(viewport.topLeft()).adjusted(-maxSize, -maxSize, maxSize, maxSize);
+    m_graph->updateStaticPrimitives(dirty);
+    if (m_graph->convexHullsVisible()) {
+        m_graph->updateConvexHulls();
+        m_graph->update();
+    } else {
+        m_graph->update(dirty.toAlignedRect());
+    }
+}
+
+// as strong as one dab of the brush at every mouse event, however many events a frame gathers: each droplet gets
+// the kernel weights at its distances to the event positions added in one go
+template <typename K>
+void PaintingWidget::paintAdditive(const std::vector<std::pair<size_t, double>> & items, const QList<QPointF> & positions, double weight)
+{
+    const K kernel{};
+    const double peak = kernel.weight(0);
+    const double r = m_brushSize / 2;
+    const auto * xAxis = m_graph->horizontalAxis();
+    const auto * yAxis = m_graph->verticalAxis();
+    for (auto [i, u] : items) {
+        QPointF p(xAxis->pixel(m_data->point(i).x()), yAxis->pixel(m_data->point(i).y()));
+        double sum = 0;
+        for (const auto & position : positions) {
+            QPointF d = p - position;
+            double v = std::sqrt(QPointF::dotProduct(d, d)) / r;
+            if (v < 1)
+                sum += kernel.weight(v);
+        }
+        if (sum == 0) continue;
+        m_data->addWeightToColorComponent(i, m_paletteButtonId, weight * sum / peak);
+        if (!m_painted[i]) m_painted.set(i, m_data->fuzzyColor(i) != m_prevColors[i]);
+    }
 }
 
 bool PaintingWidget::eventFilter(QObject *obj, QEvent *event)
 {
     if (m_graph->isEnabled() && event->type() == QEvent::MouseButtonRelease) {
-        if (std::find(m_painted.begin(), m_painted.end(), true) != m_painted.end()) {
+        m_strokeTimer->stop();
+        applyPendingStroke();
+        m_strokeAnchor.reset();
+        if (m_painted.any()) {
             PaintStrokeCommand * cmd = new PaintStrokeCommand(this, m_painted, m_prevColors);
             m_commandStack->add(cmd, false);
         }
@@ -282,87 +463,16 @@ bool PaintingWidget::eventFilter(QObject *obj, QEvent *event)
         m_graph->update();
     } else if (m_graph->isEnabled() && (event->type() == QEvent::MouseMove || event->type() == QEvent::MouseButtonPress)) {
         QMouseEvent * me = (QMouseEvent*)event;
+        QRect cursor = brushRect(m_prevMousePos) | brushRect(me->pos());
         m_prevMousePos = me->pos();
         if (m_paletteButtonId >= 0 && me->buttons().testFlag(Qt::LeftButton)) {
-
-            auto viewport = m_graph->viewportRect();
-            Point value (m_graph->horizontalAxis()->value(me->pos().x() - viewport.left()), m_graph->verticalAxis()->value(me->pos().y() - viewport.top()));
-            double w = (m_brushSize/2) / (m_graph->horizontalAxis()->pixelLength() / m_graph->horizontalAxis()->valueLength());
-            double h = (m_brushSize/2) / (m_graph->verticalAxis()->pixelLength() / m_graph->verticalAxis()->valueLength());
-            double yMultiplier = pow(w,2)/pow(h,2);
-            double w2 = pow(w, 2);
-            OrthogonalRectangle rect(value + Point(-w, -h), 2*w, 2*h);
-            viewport.translate(-viewport.topLeft());
-            QList<size_t> items;
-
-            if (m_brushStrength == 100 || flatPainting->isChecked()) { //unfuzzy painting
-                items = m_data->rectangleSearchSelection(rect, [&](size_t i) {
-                    return !m_painted[i]
-                           && viewport.contains(QPointF(m_graph->horizontalAxis()->pixel(m_data->point(i).x()), m_graph->verticalAxis()->pixel(m_data->point(i).y())))
-                           && pow(m_data->point(i).x() - value.x(),2) + pow((m_data->point(i).y() - value.y()),2) * yMultiplier < w2;
-                });
-            } else {
-                items = m_data->rectangleSearchSelection(rect, [&](size_t i) {
-                    return viewport.contains(QPointF(m_graph->horizontalAxis()->pixel(m_data->point(i).x()), m_graph->verticalAxis()->pixel(m_data->point(i).y())))
-                           && pow(m_data->point(i).x() - value.x(),2) + pow((m_data->point(i).y() - value.y()),2) * yMultiplier < w2;
-                });
-            }
-
-            if (items.size() > 0) {
-                if (m_brushStrength == 100) { // flat and unfuzzy painting, no feathering
-                    std::for_each(items.begin(), items.end(), [&](size_t i) {
-                        m_data->setColor(i, m_paletteButtonId);
-                        m_painted[i] = (m_data->fuzzyColor(i) != m_prevColors[i]);
-                    });
-                } else {
-                    if (flatPainting->isChecked()) { // flat painting, no feathering
-                        double weight = (double)m_brushStrength / 100;
-                        std::for_each(items.begin(), items.end(), [&](size_t i) {
-                            m_data->setWeightToColorComponent(i, m_paletteButtonId, weight);
-                            m_painted[i] = (m_data->fuzzyColor(i) != m_prevColors[i]);
-                        });
-                    } else {
-                        double weight = (double)m_brushStrength / 800;
-                        if (feathered->currentIndex() == 0) { // additive painting, no feathering
-                            std::for_each(items.begin(), items.end(), [&](size_t i) {
-                                m_data->addWeightToColorComponent(i, m_paletteButtonId, weight);
-                                if (!m_painted[i]) m_painted[i] = (m_data->fuzzyColor(i) != m_prevColors[i]);
-                            });
-                        } else {     // additive painting, feathered
-                            Kernel<double> * kernel = 0;
-                            switch (feathered->currentIndex()) {
-                            case 1: kernel = new EpanechnikovKernel<double>();
-                            case 2: kernel = new QuarticKernel<double>(); break;
-                            case 3: kernel = new TriWeightKernel<double>(); break;
-                            case 4: kernel = new TricubeKernel<double>(); break;
-                            default: kernel = new CosineKernel<double>();
-                            }
-                            double maxWeight = (kernel->weight(value.x(), value.x(), w) + kernel->weight(value.y(), value.y(), h));
-                            std::for_each(items.begin(), items.end(), [&](size_t i) {
-                                double kernelWeight = (kernel->weight(m_data->point(i).x(), value.x(), w) + kernel->weight(m_data->point(i).y(), value.y(), h)) / maxWeight;;
-                                m_data->addWeightToColorComponent(i, m_paletteButtonId, weight * kernelWeight);
-                                if (!m_painted[i]) m_painted[i] = (m_data->fuzzyColor(i) != m_prevColors[i]);
-                            });
-                            delete kernel;
-                        }
-                    }
-                }
-
-                double maxSize = m_graph->pointCloud()->maxMarkerSize();
-                m_graph->updateStaticPrimitives(QRect(me->pos().x() - m_brushSize / 2 - maxSize, me->pos().y() - m_brushSize / 2 - maxSize, m_brushSize + maxSize * 2, m_brushSize + maxSize * 2));
-                if (m_graph->convexHullsVisible()) {
-                    m_graph->updateConvexHulls();
-                   m_graph->update();
-                } else {
-                    QRegion region;
-                    region += QRect(m_prevMousePos - QPoint(m_brushSize / 2+1, m_brushSize / 2 + 1), QSize(2*(int)(m_brushSize / 2) + 2, 2*(int)(m_brushSize / 2) + 2));
-                    region += QRect(me->pos() - QPoint(m_brushSize / 2+1, m_brushSize / 2 + 1), QSize(2*(int)(m_brushSize / 2) + 2, 2*(int)(m_brushSize / 2) + 2));
-                    m_graph->update(region); //todo is this necessary??
-                }
-            }
+            if (event->type() == QEvent::MouseButtonPress)
+                m_strokeAnchor.reset();
+            m_pendingStroke.append(me->pos());
+            if (!m_strokeTimer->isActive())
+                m_strokeTimer->start();
         }
-
-        m_graph->update();
+        m_graph->update(cursor);
         return true;
     } else if (event->type() == QEvent::Paint) {
         QPainter paint(m_graph);
@@ -404,7 +514,8 @@ void PaintingWidget::runBoxBlur()
 
         m_blurBoxlaunchWidget->setRunningMode();
         boxBlurWorkerThread = new QThread;
-        BoxBlurWorker * worker = new BoxBlurWorker(m_data, m_graph, m_boxBlurSlider->value());
+        m_blurCancelled = false;
+        BoxBlurWorker * worker = new BoxBlurWorker(m_data, m_graph, m_boxBlurSlider->value(), m_blurKernel->currentIndex(), &m_blurCancelled);
         worker->moveToThread(boxBlurWorkerThread);
         connect(boxBlurWorkerThread, &QThread::finished, worker, &QObject::deleteLater);
         connect(this, &PaintingWidget::startBoxBlur, worker, &BoxBlurWorker::go);
@@ -428,12 +539,11 @@ void PaintingWidget::boxBlurThreadFinished()
         setEnabled(true);
         emit finishParallelWork();
     }
-    for (size_t i = 0; i < m_data->pointCount(); ++i)
-        m_painted[i] = (m_data->fuzzyColor(i) != m_prevColors[i]);
+    for (auto i : m_prevColors.changedIndices())
+        m_painted.set(i, m_data->fuzzyColor(i) != m_prevColors[i]);
     m_commandStack->add(new PaintStrokeCommand(this, m_painted, m_prevColors), false);
     beginPaintOperation();
-    m_graph->updateStaticPrimitives();
-    m_graph->update();
+    m_graph->colorsChanged();
 }
 
 void PaintingWidget::updateProgress(int i)
@@ -441,10 +551,12 @@ void PaintingWidget::updateProgress(int i)
     m_blurBoxlaunchWidget->progressBar()->setValue(i);
 }
 
-BoxBlurWorker::BoxBlurWorker(Data * data, DropletGraphWidget * graph, int sliderValue)
+BoxBlurWorker::BoxBlurWorker(Data * data, DropletGraphWidget * graph, int sliderValue, int kernel, const std::atomic<bool> * cancelled)
     : m_data(data),
     m_graph(graph),
-    m_sliderValue(sliderValue)
+    m_sliderValue(sliderValue),
+    m_kernel(kernel),
+    m_cancelled(cancelled)
 {
 }
 
@@ -452,7 +564,7 @@ void BoxBlurWorker::go()
 {
     emit updateProgress(0);
 
-    QList<size_t> selectedPoints;
+    std::vector<size_t> selectedPoints;
     selectedPoints.reserve(m_data->selectedPointCount());
     for (auto i : m_data->selectedSamples()) {
         for (size_t k = m_data->sampleIndices(i)[0]; k < m_data->sampleIndices(i)[1]; ++k) {
@@ -460,45 +572,21 @@ void BoxBlurWorker::go()
         }
     }
 
-    QList<FuzzyColor> newColors(selectedPoints.size(), FuzzyColor(m_data->colorComponentCount()));
-    QList<size_t> iota(selectedPoints.size());
-    std::iota(iota.begin(), iota.end(), 0);
-
-    int pc = 0;
-    std::atomic<int> count = 0;
-
-#ifndef Q_OS_MACOS
-    std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t & id) {
-#else
-    QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](size_t & id) {
-#endif
-        ++count;
-        int newPc = 100 * count / (int)m_data->selectedPointCount();
-        if (newPc != pc) {
-            pc = newPc;
-            emit updateProgress(pc);
-        }
-        double w = ((double)m_sliderValue/2);
-        double w2 = pow(w, 2);
-        auto value = m_data->point(selectedPoints[id]);
-        OrthogonalRectangle rect(value + Point(-w, -w), 2*w, 2*w);
-        QList<size_t> items;
-        items = m_data->rectangleSearchSelection(rect, [&](size_t i) {
-            return m_data->isSelected(i) && pow(m_data->point(i).x() - value.x(),2) + pow((m_data->point(i).y() - value.y()),2) < w2;
-        });
-        if (items.size() == 0) {
-            newColors[id] = m_data->fuzzyColor(selectedPoints[id]);
-        } else {
-            for (auto & item : items) {
-                for (auto component = 0; component < newColors[id].componentCount(); ++component)
-                    newColors[id].setWeight(component, newColors[id].weight(component) + std::max(0.0, m_data->fuzzyColor(item).weight(component)));
-            }
-            newColors[id].normalize();
-        }
-    });
-
+    // the kernels are scaled so the slider still gives the diameter of their support
+    double w = (double)m_sliderValue / 2;
+    auto progress = [this](int percent) {emit updateProgress(percent);};
+    std::vector<FuzzyColor> newColors;
+    switch (m_kernel) {
+    case 1: newColors = KernelSmoothing<EpanechnikovKernel<double>>(m_data, selectedPoints, w, w).run(progress, m_cancelled); break;
+    case 2: newColors = KernelSmoothing<QuarticKernel<double>>(m_data, selectedPoints, w, w).run(progress, m_cancelled); break;
+    case 3: newColors = KernelSmoothing<TriWeightKernel<double>>(m_data, selectedPoints, w, w).run(progress, m_cancelled); break;
+    case 4: newColors = KernelSmoothing<TricubeKernel<double>>(m_data, selectedPoints, w, w).run(progress, m_cancelled); break;
+    case 5: newColors = KernelSmoothing<CosineKernel<double>>(m_data, selectedPoints, w, w).run(progress, m_cancelled); break;
+    case 6: newColors = KernelSmoothing<GaussianKernel<double>>(m_data, selectedPoints, w / 3, w / 3).run(progress, m_cancelled); break;
+    default: newColors = BoxBlur(m_data, selectedPoints, w).run(progress, m_cancelled);
+    }
 
-    for (auto id : iota) {
+    for (size_t id = 0; id < newColors.size(); ++id) {
         m_data->setColor(selectedPoints[id], newColors[id]);
     }
 
@@ -588,8 +676,8 @@ void PaintingWidget::brushStrengthSliderValueChanged(int value)
 
 void PaintingWidget::samplesAdded()
 {
-    m_painted = QList<bool>(m_data->pointCount(), false);
-    m_prevColors = m_data->fuzzyColors();
+    m_painted = BitSet(m_data->pointCount());
+    m_prevColors = m_data->colorSnapshot();
 }
 
 void PaintingWidget::flatPaintingClicked(bool checked)
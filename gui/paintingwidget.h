@@ -1,9 +1,14 @@
 #ifndef PAINTINGWIDGET_H
 #define PAINTINGWIDGET_H
 
+#include "../core/data.h"
+#include "../core/bitset.h"
 #include "../core/fuzzycolor.h"
 #include "generic/command.h"
+#include "generic/compressedbuffer.h"
 #include <QWidget>
+#include <atomic>
+#include <optional>
 class CommandStack;
 class DropletGraphWidget;
 class Data;
@@ -15,6 +20,7 @@ class QAbstractButton;
 class QLabel;
 class QComboBox;
 class QCheckBox;
+class QTimer;
 
 class PaintingWidget : public QWidget
 {
@@ -26,15 +32,22 @@ public:
     {
     public:
 
-        PaintStrokeCommand(PaintingWidget * p, const QList<bool> & painted, const std::vector<FuzzyColor> & prevColors);
+        PaintStrokeCommand(PaintingWidget * p, const BitSet & painted, const Data::ColorSnapshot & prevColors);
 
         void redo() override;
         void undo() override;
+        size_t memoryUsage() const override {return m_record.memoryUsage();}
+        size_t diskUsage() const override {return m_record.diskUsage();}
+        bool spill() override {return m_record.spill();}
 
     private:
 
+        void apply(bool newColors);
+
         PaintingWidget * m_paintingWidget;
-        QList<std::tuple<size_t, FuzzyColor, FuzzyColor>> m_data;
+        size_t m_componentCount {0};
+        size_t m_count {0};             // droplets changed
+        CompressedBuffer m_record;      // runs of their indices, their old weights, then their new weights xor the old
     };
 
     explicit PaintingWidget(Data * data, CommandStack * cmdStack, DropletGraphWidget * graph, QWidget *parent = nullptr);
@@ -75,6 +88,10 @@ protected:
 
     bool eventFilter(QObject *obj, QEvent *event) override;
 
+private slots:
+
+    void applyPendingStroke();
+
 signals:
 
     void startBoxBlur();
@@ -83,11 +100,17 @@ signals:
 
 private:
 
+    QRect brushRect(const QPoint & pos) const;
+    template <typename K> void paintAdditive(const std::vector<std::pair<size_t, double>> & items, const QList<QPointF> & positions, double weight);
+
+    static const int StrokeInterval = 16;   // milliseconds over which mouse moves are gathered into one stroke, additive painting still adds weight per move
+
     bool m_adjustingBoxBlurSize {false};
     Data * m_data;
     CommandStack * m_commandStack;
     DropletGraphWidget * m_graph;
     QSlider * m_boxBlurSlider;
+    QComboBox * m_blurKernel;
     LaunchWidget * m_blurBoxlaunchWidget;
 
     FlowLayout * m_paletteLayout;
@@ -102,10 +125,14 @@ private:
     QCheckBox * flatPainting;
 
     QPoint m_prevMousePos;
-    QList<bool> m_painted;
-    std::vector<FuzzyColor> m_prevColors;
+    QList<QPoint> m_pendingStroke;
+    std::optional<QPointF> m_strokeAnchor;  // where the painted part of the stroke ends, in viewport pixels
+    QTimer * m_strokeTimer;
+    BitSet m_painted;
+    Data::ColorSnapshot m_prevColors;
 
     QThread * boxBlurWorkerThread {nullptr};
+    std::atomic<bool> m_blurCancelled {false};
 
 };
 
@@ -115,7 +142,7 @@ class BoxBlurWorker : public QObject
 
 public:
 
-    BoxBlurWorker(Data * data, DropletGraphWidget * graph, int sliderValue);
+    BoxBlurWorker(Data * data, DropletGraphWidget * graph, int sliderValue, int kernel, const std::atomic<bool> * cancelled);
     ~BoxBlurWorker() {}
 
 public slots:
@@ -132,7 +159,8 @@ private:
     Data * m_data;
     DropletGraphWidget * m_graph;
     int m_sliderValue;
-    int m_percent;
+    int m_kernel;                           // 0 for the flat circle, else one of the kernels of the blur box
+    const std::atomic<bool> * m_cancelled;
 };
 
 #endif // PAINTINGWIDGET_H
@@ -6,6 +6,8 @@
 #include <QGuiApplication>
 #include <QPainterPath>
 #include <QPaintEngine>
+#include <QPdfWriter>
+#include <QSvgGenerator>
 
 namespace Plot
 {
@@ -158,7 +160,7 @@ void BoxGraphBase::resizeEvent(QResizeEvent * e)
     recalculateLayout();
     m_staticPixmap = QPixmap(width() * devicePixelRatio() + 2, height() * devicePixelRatio() + 2);
     m_staticPixmap.setDevicePixelRatio(devicePixelRatio());
-    updateStaticPrimitives();
+    redrawStaticPrimitives();
 }
 
 void BoxGraphBase::paintEvent(QPaintEvent * e)
@@ -169,7 +171,17 @@ void BoxGraphBase::paintEvent(QPaintEvent * e)
     render(painter);
 }
 
+// the contents of clipRect changed, so primitives drop what they cached for it before the redraw
 void BoxGraphBase::updateStaticPrimitives(const QRectF & clipRect)
+{
+    auto viewport = viewportRect();
+    for (auto * primitive : m_staticPrimitives)
+        primitive->invalidate(clipRect.isValid() ? clipRect.translated(-viewport.topLeft()) : QRectF());
+    redrawStaticPrimitives(clipRect);
+}
+
+// only the view changed, primitives may draw from their caches
+void BoxGraphBase::redrawStaticPrimitives(const QRectF & clipRect)
 {
     QPainter paint(&m_staticPixmap);
     if (clipRect.isValid())
@@ -305,7 +317,7 @@ void BoxGraphBase::recalculateLayout()
     if (m_rightAxis) m_rightAxis->setPixelLength(viewport.height());
     if (m_topAxis) m_topAxis->setPixelLength(viewport.width());
     if (m_bottomAxis) m_bottomAxis->setPixelLength(viewport.width());
-    updateStaticPrimitives();
+    redrawStaticPrimitives();
 }
 
 void BoxGraphBase::addStaticPrimitive(Primitive * primitive)
@@ -342,4 +354,28 @@ QImage BoxGraphBase::image(double scale)
     return image;
 }
 
+void BoxGraphBase::writeSvg(const QString & fileName)
+{
+    QSvgGenerator generator;
+    generator.setFileName(fileName);
+    generator.setSize(size());
+    generator.setViewBox(rect());
+    QPainter painter(&generator);
+    painter.setClipRect(rect());
+    render(painter, true);
+}
+
+// a point per widget pixel, resolution is also the grid hidden droplets are dropped on
+void BoxGraphBase::writePdf(const QString & fileName, int resolution)
+{
+    QPdfWriter writer(fileName);
+    writer.setResolution(resolution);
+    writer.setPageSize(QPageSize(QSizeF(width(), height()), QPageSize::Point));
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+    QPainter painter(&writer);
+    painter.scale(resolution / 72.0, resolution / 72.0);
+    painter.setClipRect(rect());
+    render(painter, true);
+}
+
 } // namespace Plot
@@ -45,6 +45,7 @@ public:
 
     virtual void render(QPainter & paint, bool highQualityOutput = false) override;
     virtual void updateStaticPrimitives(const QRectF & clipRect = QRectF());
+    void redrawStaticPrimitives(const QRectF & clipRect = QRectF());
 
     QSize bufferSize() const {return m_staticPixmap.size();}
 
@@ -59,6 +60,8 @@ public:
     Axis * bottomAxis() {return m_bottomAxis;}
 
     QImage image(double scale);
+    void writeSvg(const QString & fileName);
+    void writePdf(const QString & fileName, int resolution);
 
 protected:
 
@@ -2,6 +2,7 @@
 #define FUZZYDROPLETS_GUI_PLOT_PRIMITIVE_H
 
 #include <QPalette>
+#include <QRectF>
 
 namespace Plot
 {
@@ -27,6 +28,9 @@ public:
 
     virtual void render(QPainter & painter, bool highQualityOutput = false) = 0;
 
+    // drops anything cached for rect, in viewport coordinates, or everything if rect is invalid
+    virtual void invalidate(const QRectF & rect = QRectF()) {}
+
 protected:
 
     void apply(QPainter & painter, const QPen & pen, QPalette::ColorRole colorRole);
@@ -25,7 +25,7 @@ void ScatterPlotBox2::setRange(double xMin, double xMax, double yMin, double yMa
     ((ContinuousAxis*)topAxis())->setRange(xMin, xMax);
     ((ContinuousAxis*)leftAxis())->setRange(yMin, yMax);
     ((ContinuousAxis*)rightAxis())->setRange(yMin, yMax);
-    updateStaticPrimitives();
+    redrawStaticPrimitives();
     update();
 }
 
@@ -55,7 +55,7 @@ void ScatterPlotBox2::setAbsoluteRange(double xMin, double xMax, double yMin, do
     ((ContinuousAxis*)topAxis())->setAbsoluteRange(xMin, xMax);
     ((ContinuousAxis*)leftAxis())->setAbsoluteRange(yMin, yMax);
     ((ContinuousAxis*)rightAxis())->setAbsoluteRange(yMin, yMax);
-    updateStaticPrimitives();
+    redrawStaticPrimitives();
     update();
 }
 
@@ -65,7 +65,7 @@ void ScatterPlotBox2::setupFromDataRange(double xMin, double xMax, double yMin,
     ((ContinuousAxis*)topAxis())->setupFromDataRange(xMin, xMax);
     ((ContinuousAxis*)leftAxis())->setupFromDataRange(yMin, yMax);
     ((ContinuousAxis*)rightAxis())->setupFromDataRange(yMin, yMax);
-    updateStaticPrimitives();
+    redrawStaticPrimitives();
     update();
 }
 
@@ -75,7 +75,7 @@ void ScatterPlotBox2::setupFromDataRange(OrthogonalRectangle rect)
     ((ContinuousAxis*)topAxis())->setupFromDataRange(rect.left(), rect.right());
     ((ContinuousAxis*)leftAxis())->setupFromDataRange(rect.bottom(), rect.top());
     ((ContinuousAxis*)rightAxis())->setupFromDataRange(rect.bottom(), rect.top());
-    updateStaticPrimitives();
+    redrawStaticPrimitives();
     update();
 }
 
@@ -3,11 +3,15 @@
 #include <QPaintDevice>
 #include <QPaintEngine>
 #include <execution>
+#include <numeric>
 #include <ranges>
 #include "../core/colorscheme.h"
 #include "../core/data.h"
 #include "../core/quadtree.h"
 #include <QPainterPath>
+#include <QThread>
+#include <QElapsedTimer>
+#include <unordered_map>
 #include <QtGlobal>
 
 #ifdef Q_OS_MACOS
@@ -17,6 +21,21 @@
 PointCloud::PointCloud(Data * data, Plot::ContinuousAxis * xAxis, Plot::ContinuousAxis * yAxis)
     : Primitive(), m_xAxis(xAxis), m_yAxis(yAxis), m_data(data)
 {
+    m_renderThread = new QThread;
+    m_renderer = new PointCloudRenderer(this);
+    m_renderer->moveToThread(m_renderThread);
+    connect(this, &PointCloud::renderRequested, m_renderer, &PointCloudRenderer::render);
+    connect(m_renderer, &PointCloudRenderer::tilesReady, this, &PointCloud::collectTiles);
+    m_renderThread->start();
+}
+
+PointCloud::~PointCloud()
+{
+    stopRendering();
+    m_renderThread->quit();
+    m_renderThread->wait();
+    delete m_renderer;
+    delete m_renderThread;
 }
 
 void PointCloud::render(QPainter & painter, bool highQualityOutput)
@@ -24,72 +43,642 @@ void PointCloud::render(QPainter & painter, bool highQualityOutput)
     double dpr = painter.device()->devicePixelRatio();
     viewWidth = m_xAxis->pixelLength() * dpr + 1;
     viewHeight = m_yAxis->pixelLength() * dpr + 1;
-    if (viewWidth <= 0 || viewHeight <= 0) return;
+    if (viewWidth <= 0 || viewHeight <= 0 || !m_data->quadTree()) return;
 
     int S =  m_baseSize * (1.0 + m_scaleFactor * (m_xAxis->absoluteValueLength() / m_xAxis->valueLength() - 1.0));
     int S2 = S/2 + ((S % 2) == 1);
     S /= 2;
-    auto f = painter.clipBoundingRect().adjusted(-S, -S, S, S);
+
+    if (!highQualityOutput && m_densityShading == NoDensityShading) {
+        renderTiles(painter, dpr, S, S2);
+        return;
+    }
+
+    // density mode and its shading scale depend on every droplet in the view, so clipped redraws still gather
+    // the whole view and the painter only clips the image drawn
+    QRectF area = highQualityOutput ? painter.clipBoundingRect() : QRectF(0, 0, m_xAxis->pixelLength(), m_yAxis->pixelLength());
+    auto f = area.adjusted(-S, -S, S, S);
 
     OrthogonalRectangle rect(Point(m_xAxis->value(f.left()), m_yAxis->value(f.bottom())), Point(m_xAxis->value(f.right()), m_yAxis->value(f.top())));
     QList<size_t> items = m_data->quadTree()->rectangleSearch(m_data->points(), rect, [&](size_t i){return m_data->isSelected(i);});
 
-    m_pixelData.resize(viewWidth * viewHeight);
+    if (highQualityOutput) {
+
+        double dS = 1.3 * (m_baseSize * (1.0 + m_scaleFactor * (m_xAxis->absoluteValueLength() / m_xAxis->valueLength() - 1.0)));
+        double dS2 = 1.3 * (dS/2);
+
+        if (!rasteriseMarkers(painter, items, dpr, dS, dS2))
+            drawVectorMarkers(painter, items, dpr, dS, dS2);
 
+    } else if (size_t(items.size()) * (S + S2) * (S + S2) > size_t(viewWidth) * viewHeight) {
+
+        // markers would cover the view more than once over, so draw densities and stay linear in points and pixels
+        m_pixelData.resize(viewWidth * viewHeight);
 #ifndef Q_OS_MACOS
-    std::fill(std::execution::par,m_pixelData.begin(), m_pixelData.end(), Color::named::transparent);
+        std::fill(std::execution::par,m_pixelData.begin(), m_pixelData.end(), Color::named::transparent);
 #else
-    QtConcurrent::blockingMap(m_pixelData.begin(), m_pixelData.end(), [](QRgb & color) {color = Color::named::transparent;});
+        QtConcurrent::blockingMap(m_pixelData.begin(), m_pixelData.end(), [](QRgb & color) {color = Color::named::transparent;});
 #endif
+        renderDensity(items, dpr);
 
-    const double limit = 1.0/m_data->colorComponentCount() - 0.000001;
+        QImage img(reinterpret_cast<uchar*>(m_pixelData.data()), viewWidth, viewHeight, QImage::Format_ARGB32);
+        img.setDevicePixelRatio(painter.device()->devicePixelRatio());
+        painter.drawImage(0, 0, img);
 
-    if (highQualityOutput) {
+    } else {
 
-        double dS = 1.3 * (m_baseSize * (1.0 + m_scaleFactor * (m_xAxis->absoluteValueLength() / m_xAxis->valueLength() - 1.0)));
-        double dS2 = 1.3 * (dS/2);
+        renderTiles(painter, dpr, S, S2);
+    }
+}
+
+void PointCloud::invalidate(const QRectF & rect)
+{
+    // tiles still being rendered may have read the old colours, so everything queued is cancelled
+    ++m_generation;
+    m_pending.clear();
+
+    if (!rect.isValid()) {
+        ++m_revision;  // tiles of older revisions are never looked up again and age out of the cache
+        return;
+    }
+
+    // tiles of the current view are redrawn in place where they overlap rect, others are dropped
+    OrthogonalRectangle dataRect(Point(m_xAxis->value(rect.left()), m_yAxis->value(rect.bottom())), Point(m_xAxis->value(rect.right()), m_yAxis->value(rect.top())));
+    for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+        auto & [key, tile] = *it;
+        if (!tile.bounds.overlapsWith(dataRect)) {
+            ++it;
+        } else if (TileLevel(std::get<0>(key), std::get<1>(key), std::get<2>(key), std::get<3>(key)) == m_level && std::get<6>(key) == m_revision) {
+            auto [xLevel, yLevel, S, S2, column, row, revision] = key;
+            double xUnit = std::exp2(double(xLevel) / LevelSteps);
+            double yUnit = std::exp2(double(yLevel) / LevelSteps);
+            QRect area(QPoint(int(std::floor(dataRect.left() * xUnit) - column * TileSize) - S, int(std::floor(-dataRect.top() * yUnit) - row * TileSize) - S),
+                       QPoint(int(std::floor(dataRect.right() * xUnit) - column * TileSize) + S2, int(std::floor(-dataRect.bottom() * yUnit) - row * TileSize) + S2));
+            rasteriseTile(tile, key, area.intersected(QRect(0, 0, TileSize, TileSize)), std::numeric_limits<size_t>::max());
+            ++it;
+        } else {
+            it = m_tiles.erase(it);
+        }
+    }
+}
+
+void PointCloud::stopRendering()
+{
+    ++m_generation;
+    m_pending.clear();
+    {
+        QMutexLocker locker(&m_jobMutex);
+        m_jobs.clear();
+        m_results.clear();
+    }
+    QMutexLocker locker(&m_renderMutex);    // returns once the renderer has left the data
+}
+
+void PointCloud::setRenderingPaused(bool b)
+{
+    m_renderingPaused = b;
+    if (b)
+        stopRendering();
+}
+
+void PointCloud::renderTiles(QPainter & painter, double dpr, int S, int S2)
+{
+    // the view is drawn from square tiles on a grid fixed in data space at the current scale, so panning only
+    // rasterises the tiles that come into view. Tiles of earlier zoom levels are kept until they are the least
+    // recently used. Missing tiles are first drawn from a subsample of their droplets, in parallel and within
+    // a frame budget, and the renderer thread is asked for the full tiles, which replace the previews as they
+    // arrive. A change of zoom level cancels the full tiles still queued for the previous one.
 
-        for (auto col : m_data->colorZOrder()) {
-            std::for_each(items.begin(), items.end(), [&](const auto & p) { // can't be parallel
-                if (m_data->fuzzyColor(p).dominantComponent() == col) { // it's not clear if this will be slower than just asking if the weight of col > 1.0/m_data->colorComponentCount() [which risks repainting each droplet multiple times when there is a lot of fuzziness in the graph; alternative, keep track of which have been painted and and only paint once per droplet?]
-                    auto pt = m_data->point(p);
-                    if (m_roundSVGMarkers) {
-                        painter.setBrush(QColor::fromRgb(m_data->rgba(p)));
-                        painter.drawEllipse(QRectF(m_xAxis->pixel(pt.x()) * dpr - dS, m_yAxis->pixel(pt.y()) * dpr - dS, dS2, dS2));
-                    } else {
-                        painter.fillRect(QRectF(m_xAxis->pixel(pt.x()) * dpr - dS, m_yAxis->pixel(pt.y()) * dpr - dS, dS2, dS2), QColor::fromRgb(m_data->rgba(p)));
-                    }
+    // scales are snapped to fine steps so that rounding noise in the axis ranges does not change the zoom level
+    qint64 xLevel = std::llround(std::log2(m_xAxis->pixelLength() * dpr / m_xAxis->valueLength()) * LevelSteps);
+    qint64 yLevel = std::llround(std::log2(m_yAxis->pixelLength() * dpr / m_yAxis->valueLength()) * LevelSteps);
+    double xUnit = std::exp2(double(xLevel) / LevelSteps);
+    double yUnit = std::exp2(double(yLevel) / LevelSteps);
+    double originX = std::round(m_xAxis->minimum() * xUnit);   // whole device pixels, so tiles meet without seams
+    double originY = std::round(-m_yAxis->maximum() * yUnit);
+
+    if (TileLevel(xLevel, yLevel, S, S2) != m_level) {
+        m_level = {xLevel, yLevel, S, S2};
+        ++m_generation;
+        m_pending.clear();
+    }
+
+    QRectF view(0, 0, m_xAxis->pixelLength(), m_yAxis->pixelLength());
+    QRectF clip = painter.hasClipping() ? painter.clipBoundingRect().intersected(view) : view;
+    if (clip.isEmpty()) return;
+    qint64 firstColumn = std::floor((originX + clip.left() * dpr) / TileSize);
+    qint64 lastColumn = std::floor((originX + clip.right() * dpr) / TileSize);
+    qint64 firstRow = std::floor((originY + clip.top() * dpr) / TileSize);
+    qint64 lastRow = std::floor((originY + clip.bottom() * dpr) / TileSize);
+
+    ++m_frame;
+    std::vector<TileKey> visible;
+    std::vector<TileKey> missing;
+    for (qint64 row = firstRow; row <= lastRow; ++row) {
+        for (qint64 column = firstColumn; column <= lastColumn; ++column) {
+            visible.push_back({xLevel, yLevel, S, S2, column, row, m_revision});
+            if (!m_tiles.contains(visible.back()))
+                missing.push_back(visible.back());
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<Tile> rendered(missing.size());
+#ifndef Q_OS_MACOS
+    auto tiles = std::ranges::views::iota((size_t)0, missing.size());
+    std::for_each(std::execution::par, tiles.begin(), tiles.end(), [&](size_t i) {
+#else
+    QList<size_t> tiles(missing.size(), 0);
+    std::iota(tiles.begin(), tiles.end(), 0);
+    QtConcurrent::blockingMap(tiles.begin(), tiles.end(), [&](const size_t & i) {
+#endif
+        if (timer.elapsed() < FrameBudget)
+            rendered[i] = renderTile(missing[i], PreviewPointCount);
+    });
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (!rendered[i].image.isNull())
+            m_tiles.emplace(missing[i], std::move(rendered[i]));
+    }
+
+    std::vector<Job> jobs;
+    for (const auto & key : visible) {
+        auto it = m_tiles.find(key);
+        if ((it == m_tiles.end() || it->second.preview) && !m_renderingPaused && m_pending.insert(key).second)
+            jobs.push_back({key, m_generation});
+        if (it != m_tiles.end()) {
+            it->second.lastUsed = m_frame;
+            it->second.image.setDevicePixelRatio(dpr);
+            painter.drawImage(QPointF((std::get<4>(key) * TileSize - originX) / dpr, (std::get<5>(key) * TileSize - originY) / dpr), it->second.image);
+        }
+    }
+    if (!jobs.empty()) {
+        QMutexLocker locker(&m_jobMutex);
+        m_jobs.insert(m_jobs.end(), jobs.begin(), jobs.end());
+        emit renderRequested();
+    }
+
+    size_t maxTileCount = std::max(size_t(MinCachedTileCount), 2 * visible.size());
+    if (m_tiles.size() > maxTileCount) {
+        // the least recently used tiles over the limit, found in one pass
+        std::vector<std::map<TileKey, Tile>::iterator> tiles;
+        tiles.reserve(m_tiles.size());
+        for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it)
+            tiles.push_back(it);
+        auto last = tiles.begin() + (m_tiles.size() - maxTileCount);
+        std::nth_element(tiles.begin(), last, tiles.end(), [](const auto & left, const auto & right) {return left->second.lastUsed < right->second.lastUsed;});
+        for (auto it = tiles.begin(); it != last; ++it)
+            m_tiles.erase(*it);
+    }
+}
+
+void PointCloud::collectTiles()
+{
+    std::vector<std::pair<Job, Tile>> results;
+    {
+        QMutexLocker locker(&m_jobMutex);
+        results.swap(m_results);
+    }
+    bool added = false;
+    for (auto & [job, tile] : results) {
+        if (job.generation == m_generation && !tile.image.isNull()) {
+            m_pending.erase(job.key);
+            tile.lastUsed = m_frame;
+            m_tiles[job.key] = std::move(tile);
+            added = true;
+        }
+    }
+    if (added)
+        emit tilesRendered();
+}
+
+PointCloud::Tile PointCloud::renderTile(const TileKey & key, size_t maxPoints) const
+{
+    auto [xLevel, yLevel, S, S2, column, row, revision] = key;
+    double xUnit = std::exp2(double(xLevel) / LevelSteps);
+    double yUnit = std::exp2(double(yLevel) / LevelSteps);
+
+    Tile tile;
+    tile.image = QImage(TileSize, TileSize, QImage::Format_ARGB32);
+    double xMargin = (S + S2) / xUnit;
+    double yMargin = (S + S2) / yUnit;
+    tile.bounds = OrthogonalRectangle(Point(column * TileSize / xUnit - xMargin, -(row + 1) * TileSize / yUnit - yMargin),
+                                      Point((column + 1) * TileSize / xUnit + xMargin, -row * TileSize / yUnit + yMargin));
+    tile.preview = rasteriseTile(tile, key, QRect(0, 0, TileSize, TileSize), maxPoints);
+    return tile;
+}
+
+// clears area of the tile and draws the droplets that reach into it, every nth one if there are more than
+// maxPoints. Returns true if the droplets were subsampled.
+bool PointCloud::rasteriseTile(Tile & tile, const TileKey & key, const QRect & area, size_t maxPoints) const
+{
+    if (area.isEmpty()) return false;
+    auto [xLevel, yLevel, S, S2, column, row, revision] = key;
+    double xUnit = std::exp2(double(xLevel) / LevelSteps);
+    double yUnit = std::exp2(double(yLevel) / LevelSteps);
+
+    QRgb * pixels = reinterpret_cast<QRgb*>(tile.image.bits());
+    for (int y = area.top(); y <= area.bottom(); ++y)
+        std::fill(pixels + y * TileSize + area.left(), pixels + y * TileSize + area.right() + 1, Color::named::transparent);
+
+    OrthogonalRectangle rect(Point((column * TileSize + area.left() - S2) / xUnit, -(row * TileSize + area.bottom() + 1 + S) / yUnit),
+                             Point((column * TileSize + area.right() + 1 + S) / xUnit, -(row * TileSize + area.top() - S2) / yUnit));
+    QList<size_t> items = m_data->quadTree()->rectangleSearch(m_data->points(), rect, [&](size_t i){return m_data->isSelected(i);});
+    size_t step = std::max<size_t>(1, (items.size() + maxPoints - 1) / maxPoints);
+
+    splat(S, S2, drawOrder(items, step, false), xUnit, -yUnit, column * TileSize, row * TileSize, pixels, TileSize, area);
+    return step > 1;
+}
+
+// high quality markers for image export written straight into the pixels of the painter's image, the same shapes
+// the QPainter path draws but antialiased by exact pixel coverage. The clip area is cut into horizontal bands that
+// are drawn in parallel, each droplet is listed in draw order in every band it reaches. Returns false if the device
+// is not an ARGB image or the painter rotates or shears, then the caller draws with QPainter.
+bool PointCloud::rasteriseMarkers(QPainter & painter, const QList<size_t> & items, double dpr, double dS, double dS2) const
+{
+    if (painter.device()->devType() != QInternal::Image) return false;
+    QImage * image = static_cast<QImage*>(painter.device());
+    QTransform transform = painter.deviceTransform();
+    if ((image->format() != QImage::Format_ARGB32 && image->format() != QImage::Format_RGB32) || transform.type() > QTransform::TxScale)
+        return false;
+
+    QRect clip = painter.hasClipping() ? transform.mapRect(painter.clipBoundingRect()).toAlignedRect().intersected(image->rect()) : image->rect();
+    if (clip.isEmpty() || items.empty()) return true;
+
+    auto order = drawOrder(items, 1, true);
+    double width = dS2 * std::abs(transform.m11());
+    double height = dS2 * std::abs(transform.m22());
+    std::vector<double> left(order.size());
+    std::vector<double> top(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        auto pt = m_data->point(order[i]);
+        auto corner = transform.map(QPointF(m_xAxis->pixel(pt.x()) * dpr - dS, m_yAxis->pixel(pt.y()) * dpr - dS));
+        left[i] = transform.m11() < 0 ? corner.x() - width : corner.x();
+        top[i] = transform.m22() < 0 ? corner.y() - height : corner.y();
+    }
+
+    int bandCount = (clip.height() + ExportBandHeight - 1) / ExportBandHeight;
+    auto bandOf = [&](double y) {return std::clamp(int(std::floor(y - clip.top())) / ExportBandHeight, 0, bandCount - 1);};
+    std::vector<size_t> bandStart(bandCount + 1, 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (top[i] + height > clip.top() && top[i] < clip.bottom() + 1) {
+            for (int b = bandOf(top[i]); b <= bandOf(top[i] + height); ++b)
+                ++bandStart[b + 1];
+        }
+    }
+    std::partial_sum(bandStart.begin(), bandStart.end(), bandStart.begin());
+    std::vector<size_t> banded(bandStart.back());
+    std::vector<size_t> next(bandStart.begin(), bandStart.end() - 1);
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (top[i] + height > clip.top() && top[i] < clip.bottom() + 1) {
+            for (int b = bandOf(top[i]); b <= bandOf(top[i] + height); ++b)
+                banded[next[b]++] = i;
+        }
+    }
+
+    QRgb * pixels = reinterpret_cast<QRgb*>(image->bits());
+    qsizetype stride = image->bytesPerLine() / sizeof(QRgb);
+    bool round = m_roundSVGMarkers;
+
+#ifndef Q_OS_MACOS
+    auto bands = std::ranges::views::iota(0, bandCount);
+    std::for_each(std::execution::par, bands.begin(), bands.end(), [&](int band) {
+#else
+    QList<int> bands(bandCount, 0);
+    std::iota(bands.begin(), bands.end(), 0);
+    QtConcurrent::blockingMap(bands.begin(), bands.end(), [&](const int & band) {
+#endif
+        int bandTop = clip.top() + band * ExportBandHeight;
+        int bandBottom = std::min(clip.bottom() + 1, bandTop + ExportBandHeight);
+        for (size_t j = bandStart[band]; j < bandStart[band + 1]; ++j) {
+            size_t i = banded[j];
+            Color::Rgba rgb = m_data->rgba(order[i]);
+            double cx = left[i] + width / 2;
+            double cy = top[i] + height / 2;
+            double r = std::min(width, height) / 2;
+            int x0 = std::max(clip.left(), int(std::floor(left[i])));
+            int x1 = std::min(clip.right() + 1, int(std::ceil(left[i] + width)));
+            int y0 = std::max(bandTop, int(std::floor(top[i])));
+            int y1 = std::min(bandBottom, int(std::ceil(top[i] + height)));
+            for (int y = y0; y < y1; ++y) {
+                QRgb * row = pixels + y * stride;
+                double coverageY = std::min(y + 1.0, top[i] + height) - std::max(double(y), top[i]);
+                for (int x = x0; x < x1; ++x) {
+                    double coverage = round ? std::clamp(r + 0.5 - std::hypot(x + 0.5 - cx, y + 0.5 - cy), 0.0, 1.0)
+                                            : coverageY * (std::min(x + 1.0, left[i] + width) - std::max(double(x), left[i]));
+                    int alpha = int(std::round(Color::alpha(rgb) * coverage));
+                    if (alpha == 255)
+                        row[x] = rgb;
+                    else if (alpha > 0)
+                        row[x] = Color::alphaBlend(row[x], Color::setAlpha(rgb, alpha));
                 }
-            });
+            }
         }
+    });
+    return true;
+}
 
-    } else {
+// vector output. Of the droplets whose markers centre on the same device pixel only the one drawn last can be seen,
+// so the others are left out, and each run of markers of one colour is filled as a single path. Output size then
+// follows the number of visible markers and colour changes rather than the droplet count.
+void PointCloud::drawVectorMarkers(QPainter & painter, const QList<size_t> & items, double dpr, double dS, double dS2) const
+{
+    auto order = drawOrder(items, 1, true);
+    QTransform transform = painter.deviceTransform();
+    std::vector<QRectF> markers(order.size());
+    auto pixelOf = [&](const QRectF & marker) {
+        auto centre = transform.map(marker.center());
+        return (qint64(std::floor(centre.y())) << 32) | (qint64(std::floor(centre.x())) & 0xffffffff);
+    };
+    std::unordered_map<qint64, size_t> lastInPixel;
+    lastInPixel.reserve(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        auto pt = m_data->point(order[i]);
+        markers[i] = QRectF(m_xAxis->pixel(pt.x()) * dpr - dS, m_yAxis->pixel(pt.y()) * dpr - dS, dS2, dS2);
+        lastInPixel[pixelOf(markers[i])] = i;
+    }
+
+    QPainterPath path;
+    path.setFillRule(Qt::WindingFill);
+    QRgb pathColor = 0;
+    auto fill = [&]() {
+        if (!path.isEmpty())
+            painter.fillPath(path, QColor::fromRgb(pathColor));
+        path.clear();
+    };
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (lastInPixel[pixelOf(markers[i])] != i) continue;
+        QRgb rgb = m_data->rgba(order[i]);
+        if (rgb != pathColor) {
+            fill();
+            pathColor = rgb;
+        }
+        if (m_roundSVGMarkers)
+            path.addEllipse(markers[i]);
+        else
+            path.addRect(markers[i]);
+    }
+    fill();
+}
+
+// every step-th droplet of items, stably sorted by the z order layer it is drawn in so that a single pass paints
+// the same picture as one pass per colour. A droplet's layer is the topmost colour holding at least an even share
+// of its weight (the last pass that used to draw it), or its dominant colour if dominantOnly. Counting sort over
+// blocks: each block counts its layers, a prefix sum over (layer, block) gives every block its own output slots.
+std::vector<size_t> PointCloud::drawOrder(const QList<size_t> & items, size_t step, bool dominantOnly) const
+{
+    const auto & zOrder = m_data->colorZOrder();
+    std::vector<size_t> layerOfColor(m_data->colorComponentCount(), 0);  // 0 for colours that are not drawn
+    for (size_t l = 0; l < zOrder.size(); ++l)
+        layerOfColor[zOrder[l]] = l + 1;
+    const size_t layerCount = zOrder.size() + 1;
+    const double limit = 1.0/m_data->colorComponentCount() - 0.000001;
+
+    size_t count = (items.size() + step - 1) / step;
+    size_t blockCount = (count + DrawOrderBlockSize - 1) / DrawOrderBlockSize;
+    std::vector<size_t> layer(count, 0);
+    std::vector<size_t> slots(blockCount * layerCount, 0);
 
-        for (auto col : m_data->colorZOrder()) {
 #ifndef Q_OS_MACOS
-            std::for_each(std::execution::par, items.begin(), items.end(), [&](const auto & p) {
+    auto blocks = std::ranges::views::iota((size_t)0, blockCount);
+    std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](size_t b) {
 #else
-            QtConcurrent::blockingMap(items.begin(), items.end(), [&](auto & p) {
+    QList<size_t> blocks(blockCount, 0);
+    std::iota(blocks.begin(), blocks.end(), 0);
+    QtConcurrent::blockingMap(blocks.begin(), blocks.end(), [&](const size_t & b) {
 #endif
-                //if (m_data->fuzzyColor(p).dominantComponent() == col) {
-                if (m_data->fuzzyColor(p).weight(col) >= limit) {
-                    auto pt = m_data->point(p);
-                    drawSquare(S, S2, m_xAxis->pixel(pt.x()) * dpr, m_yAxis->pixel(pt.y()) * dpr, m_data->rgba(p), m_pixelData);
+        for (size_t i = b * DrawOrderBlockSize; i < std::min(count, (b + 1) * DrawOrderBlockSize); ++i) {
+            const auto & color = m_data->fuzzyColor(items[i * step]);
+            if (dominantOnly) {
+                layer[i] = layerOfColor[color.dominantComponent()];
+            } else {
+                for (size_t k = 0; k < layerOfColor.size(); ++k) {
+                    if (color.weight(k) >= limit)
+                        layer[i] = std::max(layer[i], layerOfColor[k]);
                 }
-            });
+            }
+            ++slots[b * layerCount + layer[i]];
         }
+    });
 
-        QImage img(reinterpret_cast<uchar*>(m_pixelData.data()), viewWidth, viewHeight, QImage::Format_ARGB32);
-        img.setDevicePixelRatio(painter.device()->devicePixelRatio());
-        painter.drawImage(0, 0, img);
+    size_t total = 0;
+    for (size_t l = 1; l < layerCount; ++l) {
+        for (size_t b = 0; b < blockCount; ++b) {
+            size_t n = slots[b * layerCount + l];
+            slots[b * layerCount + l] = total;
+            total += n;
+        }
+    }
+
+    std::vector<size_t> order(total);
+#ifndef Q_OS_MACOS
+    std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](size_t b) {
+#else
+    QtConcurrent::blockingMap(blocks.begin(), blocks.end(), [&](const size_t & b) {
+#endif
+        for (size_t i = b * DrawOrderBlockSize; i < std::min(count, (b + 1) * DrawOrderBlockSize); ++i) {
+            if (layer[i] > 0)
+                order[slots[b * layerCount + layer[i]]++] = items[i * step];
+        }
+    });
+    return order;
+}
+
+void PointCloud::drawSquare(int S, int S2, int x, int y, QRgb rgb, QRgb * pixels, int width, const QRect & area)
+{
+    int left = std::max(area.left(), x - S);
+    int right = std::min(area.right() + 1, x + S2);
+    if (left >= right) return;
+    for (int Y = std::max(area.top(), y - S); Y < std::min(area.bottom() + 1, y + S2); ++Y)
+        std::fill(pixels + Y * width + left, pixels + Y * width + right, rgb);
+}
+
+// markers W pixels wide that lie entirely inside area are written as fixed size rows the compiler unrolls into
+// vector stores, the few that are clipped go through drawSquare
+template <int W>
+void PointCloud::splatBlock(int S, int S2, const int * xs, const int * ys, const QRgb * colors, size_t n, QRgb * pixels, int width, const QRect & area)
+{
+    for (size_t i = 0; i < n; ++i) {
+        int x = xs[i] - S;
+        int y = ys[i] - S;
+        if (x >= area.left() && x + W <= area.right() + 1 && y >= area.top() && y + W <= area.bottom() + 1) {
+            QRgb * row = pixels + y * width + x;
+            for (int r = 0; r < W; ++r, row += width) {
+                for (int c = 0; c < W; ++c)
+                    row[c] = colors[i];
+            }
+        } else {
+            drawSquare(S, S2, xs[i], ys[i], colors[i], pixels, width, area);
+        }
+    }
+}
+
+// draws the droplets of order into area of an image width pixels wide whose top left corner is at pixel (xOrigin,
+// yOrigin) of the scale xUnit, yUnit. Positions and colours are gathered a block at a time into flat arrays so the
+// transform runs over contiguous data, then the block is splatted with the kernel for its marker size.
+void PointCloud::splat(int S, int S2, const std::vector<size_t> & order, double xUnit, double yUnit, qint64 xOrigin, qint64 yOrigin, QRgb * pixels, int width, const QRect & area) const
+{
+    int xs[SplatBlockSize];
+    int ys[SplatBlockSize];
+    QRgb colors[SplatBlockSize];
+    const auto & points = m_data->points();
+    for (size_t first = 0; first < order.size(); first += SplatBlockSize) {
+        size_t n = std::min<size_t>(SplatBlockSize, order.size() - first);
+        const size_t * block = order.data() + first;
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = int(qint64(std::floor(points[block[i]].x() * xUnit)) - xOrigin);
+            ys[i] = int(qint64(std::floor(points[block[i]].y() * yUnit)) - yOrigin);
+        }
+        for (size_t i = 0; i < n; ++i)
+            colors[i] = m_data->rgba(block[i]);
+
+        switch (S + S2) {
+        case 1: splatBlock<1>(S, S2, xs, ys, colors, n, pixels, width, area); break;
+        case 2: splatBlock<2>(S, S2, xs, ys, colors, n, pixels, width, area); break;
+        case 3: splatBlock<3>(S, S2, xs, ys, colors, n, pixels, width, area); break;
+        default:
+            for (size_t i = 0; i < n; ++i)
+                drawSquare(S, S2, xs[i], ys[i], colors[i], pixels, width, area);
+        }
+    }
+}
+
+void PointCloudRenderer::render()
+{
+    std::vector<PointCloud::Job> jobs;
+    {
+        QMutexLocker locker(&m_cloud->m_jobMutex);
+        jobs.swap(m_cloud->m_jobs);
+    }
+    std::erase_if(jobs, [&](const auto & job) {return job.generation != m_cloud->m_generation;});
+    if (jobs.empty()) return;
+
+    std::vector<PointCloud::Tile> tiles(jobs.size());
+    {
+        QMutexLocker locker(&m_cloud->m_renderMutex);
+#ifndef Q_OS_MACOS
+        auto iota = std::ranges::views::iota((size_t)0, jobs.size());
+        std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t i) {
+#else
+        QList<size_t> iota(jobs.size(), 0);
+        std::iota(iota.begin(), iota.end(), 0);
+        QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & i) {
+#endif
+            if (jobs[i].generation == m_cloud->m_generation)
+                tiles[i] = m_cloud->renderTile(jobs[i].key, std::numeric_limits<size_t>::max());
+        });
+    }
+
+    {
+        QMutexLocker locker(&m_cloud->m_jobMutex);
+        for (size_t i = 0; i < jobs.size(); ++i)
+            m_cloud->m_results.emplace_back(jobs[i], std::move(tiles[i]));
     }
+    emit tilesReady();
 }
 
-void PointCloud::drawSquare(int S, int S2, size_t x, size_t y, QRgb rgb, std::vector<QRgb> & pixels)
+void PointCloud::renderDensity(const QList<size_t> & items, double dpr)
 {
-    for (int Y = std::max(0, (int)(y - S)); Y < std::min(viewHeight - 1, (int)(y + S2)); ++Y) {
-        for (int X = std::max(0, (int)(x - S)); X < std::min(viewWidth - 1, (int)(x + S2)); ++X) {
-            pixels[Y * viewWidth + X] = rgb;
+    // datashader style aggregation. The droplets are binned by horizontal band of the image, each band sums the
+    // component weights of its droplets per pixel into a local buffer and mixes the component colours, and the
+    // pixel totals then set the alpha through a log or equalised histogram scale. Bands never share pixels.
+
+    size_t componentCount = m_data->colorComponentCount();
+    size_t pixelCount = m_pixelData.size();
+    size_t bandHeight = (viewHeight + 4 * QThread::idealThreadCount() - 1) / (4 * QThread::idealThreadCount());
+    size_t bandCount = (viewHeight + bandHeight - 1) / bandHeight;
+    const size_t offImage = pixelCount;
+
+    std::vector<size_t> pixel(items.size());
+
+#ifndef Q_OS_MACOS
+    auto positions = std::ranges::views::iota((size_t)0, (size_t)items.size());
+    std::for_each(std::execution::par, positions.begin(), positions.end(), [&](size_t i) {
+#else
+    QList<size_t> positions(items.size(), 0);
+    std::iota(positions.begin(), positions.end(), 0);
+    QtConcurrent::blockingMap(positions.begin(), positions.end(), [&](const size_t & i) {
+#endif
+        auto pt = m_data->point(items[i]);
+        double x = m_xAxis->pixel(pt.x()) * dpr;
+        double y = m_yAxis->pixel(pt.y()) * dpr;
+        pixel[i] = (x >= 0 && x < viewWidth && y >= 0 && y < viewHeight) ? size_t(y) * viewWidth + size_t(x) : offImage;
+    });
+
+    std::vector<size_t> bandStart(bandCount + 1, 0);
+    for (auto p : pixel) {
+        if (p != offImage)
+            ++bandStart[p / viewWidth / bandHeight + 1];
+    }
+    std::partial_sum(bandStart.begin(), bandStart.end(), bandStart.begin());
+    std::vector<size_t> order(bandStart.back());
+    std::vector<size_t> next(bandStart.begin(), bandStart.end() - 1);
+    for (size_t i = 0; i < pixel.size(); ++i) {
+        if (pixel[i] != offImage)
+            order[next[pixel[i] / viewWidth / bandHeight]++] = i;
+    }
+
+    m_densityTotals.assign(pixelCount, 0);
+    auto schemeColors = m_data->colorScheme()->colors(0, componentCount - 1);
+    std::vector<Color::Rgba> baseColors(schemeColors.begin(), schemeColors.end());
+
+#ifndef Q_OS_MACOS
+    auto bands = std::ranges::views::iota((size_t)0, bandCount);
+    std::for_each(std::execution::par, bands.begin(), bands.end(), [&](size_t band) {
+#else
+    QList<size_t> bands(bandCount, 0);
+    std::iota(bands.begin(), bands.end(), 0);
+    QtConcurrent::blockingMap(bands.begin(), bands.end(), [&](const size_t & band) {
+#endif
+        size_t first = band * bandHeight * viewWidth;
+        size_t last = std::min(first + bandHeight * viewWidth, pixelCount);
+        std::vector<float> counts((last - first) * componentCount, 0);
+        for (size_t j = bandStart[band]; j < bandStart[band + 1]; ++j) {
+            const auto & weights = m_data->fuzzyColor(items[order[j]]).weights();
+            float * c = counts.data() + (pixel[order[j]] - first) * componentCount;
+            for (size_t k = 0; k < componentCount; ++k)
+                c[k] += weights[k];
+        }
+        std::vector<double> mix(componentCount);
+        for (size_t p = first; p < last; ++p) {
+            const float * c = counts.data() + (p - first) * componentCount;
+            float total = std::accumulate(c, c + componentCount, 0.0f);
+            m_densityTotals[p] = total;
+            if (total > 0) {
+                for (size_t k = 0; k < componentCount; ++k)
+                    mix[k] = c[k] / total;
+                m_pixelData[p] = Color::additiveMixture(baseColors, mix);
+            }
         }
+    });
+
+    std::vector<float> shadeScale;
+    if (m_densityShading == EqualisedDensityShading) {
+        std::copy_if(m_densityTotals.begin(), m_densityTotals.end(), std::back_inserter(shadeScale), [](float t) {return t > 0;});
+#ifndef Q_OS_MACOS
+        std::sort(std::execution::par, shadeScale.begin(), shadeScale.end());
+#else
+        std::sort(shadeScale.begin(), shadeScale.end());
+#endif
+    } else {
+        shadeScale.push_back(std::log1p(*std::max_element(m_densityTotals.begin(), m_densityTotals.end())));
     }
+
+#ifndef Q_OS_MACOS
+    std::for_each(std::execution::par, bands.begin(), bands.end(), [&](size_t band) {
+#else
+    QtConcurrent::blockingMap(bands.begin(), bands.end(), [&](const size_t & band) {
+#endif
+        size_t first = band * bandHeight * viewWidth;
+        size_t last = std::min(first + bandHeight * viewWidth, pixelCount);
+        for (size_t p = first; p < last; ++p) {
+            float total = m_densityTotals[p];
+            if (total > 0) {
+                double shade = (m_densityShading == EqualisedDensityShading) ?
+                                   double(std::upper_bound(shadeScale.begin(), shadeScale.end(), total) - shadeScale.begin()) / shadeScale.size() :
+                                   std::log1p(total) / shadeScale[0];
+                m_pixelData[p] = Color::setAlpha(m_pixelData[p], MinDensityAlpha + int(std::round((255 - MinDensityAlpha) * std::clamp(shade, 0.0, 1.0))));
+            }
+        }
+    });
 }
@@ -3,17 +3,55 @@
 
 #include "plot/continuousaxis.h"
 #include "../core/geometry.h"
+#include <QImage>
+#include <QObject>
+#include <QMutex>
+#include <atomic>
+#include <map>
+#include <set>
 
 class Data;
+class QThread;
+class PointCloud;
 template <typename T> class QuadTree;
 
-class PointCloud : public Plot::Primitive
+// rasterises the full quality tiles PointCloud asks for, on its own thread
+class PointCloudRenderer : public QObject
 {
+    Q_OBJECT
+
+public:
+
+    PointCloudRenderer(PointCloud * cloud) : m_cloud(cloud) {}
+
+    void render();
+
+signals:
+
+    void tilesReady();
+
+private:
+
+    PointCloud * m_cloud;
+};
+
+class PointCloud : public QObject, public Plot::Primitive
+{
+    Q_OBJECT
+
+    friend class PointCloudRenderer;
+
 public:
 
+    enum DensityShading {NoDensityShading, LogDensityShading, EqualisedDensityShading};
+
     PointCloud(Data * data, Plot::ContinuousAxis * xAxis, Plot::ContinuousAxis * yAxis);
+    ~PointCloud();
 
     void render(QPainter & painter, bool highQualityOutput = false);
+    void invalidate(const QRectF & rect = QRectF());
+    void stopRendering();           // cancels background tiles and waits for the renderer, call before the data's storage changes
+    void setRenderingPaused(bool b);    // while paused only previews are drawn, for when other threads write the colours
 
     void setScaleFactor(double scaleFactor) {m_scaleFactor = std::clamp(scaleFactor, 0.0, 1.0);}
     double scaleFactor() const {return m_scaleFactor;}
@@ -26,9 +64,59 @@ public:
 
     void setRoundSvgMarkers(bool b) {m_roundSVGMarkers = b;}
 
+    // when not NoDensityShading, overplotted views are drawn as per pixel colour densities instead of markers
+    void setDensityShading(DensityShading shading) {m_densityShading = shading;}
+    DensityShading densityShading() const {return m_densityShading;}
+
+signals:
+
+    void renderRequested();
+    void tilesRendered();           // full quality tiles replaced previews, the view should be redrawn
+
+private slots:
+
+    void collectTiles();
+
 private:
 
-    inline void drawSquare(int S, int S2, size_t x, size_t y, QRgb rgb, std::vector<QRgb> & pixels);
+    // x and y zoom levels, marker extents, tile column and row, revision
+    using TileKey = std::tuple<qint64, qint64, int, int, qint64, qint64, size_t>;
+    using TileLevel = std::tuple<qint64, qint64, int, int>;
+
+    struct Tile
+    {
+        QImage image;
+        OrthogonalRectangle bounds;     // data covered by the tile's markers
+        size_t lastUsed {0};
+        bool preview {false};           // drawn from a subsample of the droplets
+    };
+
+    struct Job
+    {
+        TileKey key;
+        size_t generation;
+    };
+
+    static inline void drawSquare(int S, int S2, int x, int y, QRgb rgb, QRgb * pixels, int width, const QRect & area);
+    template <int W> static void splatBlock(int S, int S2, const int * xs, const int * ys, const QRgb * colors, size_t n, QRgb * pixels, int width, const QRect & area);
+    void splat(int S, int S2, const std::vector<size_t> & order, double xUnit, double yUnit, qint64 xOrigin, qint64 yOrigin, QRgb * pixels, int width, const QRect & area) const;
+    void renderDensity(const QList<size_t> & items, double dpr);
+    void renderTiles(QPainter & painter, double dpr, int S, int S2);
+    Tile renderTile(const TileKey & key, size_t maxPoints) const;
+    bool rasteriseTile(Tile & tile, const TileKey & key, const QRect & area, size_t maxPoints) const;
+    std::vector<size_t> drawOrder(const QList<size_t> & items, size_t step, bool dominantOnly) const;
+    bool rasteriseMarkers(QPainter & painter, const QList<size_t> & items, double dpr, double dS, double dS2) const;
+    void drawVectorMarkers(QPainter & painter, const QList<size_t> & items, double dpr, double dS, double dS2) const;
+
+    static const int MinDensityAlpha = 48;
+    static const int TileSize = 256;
+    static const int LevelSteps = 1 << 16;     // zoom levels per doubling of scale
+    static const size_t MinCachedTileCount = 256;
+    static const size_t PreviewPointCount = 4096;   // droplets per preview tile
+    static const int FrameBudget = 15;              // milliseconds spent on previews per frame
+    static const size_t DrawOrderBlockSize = 4096;
+    static const size_t SplatBlockSize = 256;
+    static const int ExportBandHeight = 32;         // image rows per band of high quality raster output
 
     Plot::ContinuousAxis * m_xAxis;
     Plot::ContinuousAxis * m_yAxis;
@@ -41,10 +129,29 @@ private:
     int viewWidth{0};
     int viewHeight{0};
     std::vector<QRgb> m_pixelData;
+    std::vector<float> m_densityTotals;
+
+    std::map<TileKey, Tile> m_tiles;
+    size_t m_revision {0};
+    size_t m_frame {0};
+    TileLevel m_level;
+
+    // background rendering, jobs and results are guarded by m_jobMutex and the renderer holds m_renderMutex
+    // while it reads the data. Jobs and results of an older generation are dropped.
+    QThread * m_renderThread;
+    PointCloudRenderer * m_renderer;
+    std::atomic<size_t> m_generation {0};
+    std::set<TileKey> m_pending;
+    std::vector<Job> m_jobs;
+    std::vector<std::pair<Job, Tile>> m_results;
+    QMutex m_jobMutex;
+    QMutex m_renderMutex;
+    bool m_renderingPaused {false};
 
     const QuadTree<Point> * m_quadTree {nullptr};
 
     bool m_roundSVGMarkers {false};
+    DensityShading m_densityShading {NoDensityShading};
 };
 
 
@@ -1,17 +1,31 @@
 #include "randomforestwidget.h"
+#include "generic/themedicon.h"
 #include <QFormLayout>
 #include <QThread>
 #include "../core/data.h"
-#include "../ranger/ForestClassification.h"
+#include "../core/mapped_file.hpp"
+#include "../ranger/DataDouble.h"
+#include "../ranger/DataFloat.h"
+#include "../ranger/ForestModel.h"
 #include "../ranger/ForestProbability.h"
 #include "../ranger/globals.h"
 #include <fstream>
-#include <QFile>
-#include <QTextStream>
 #include <QDir>
-#include <QCoreApplication>
+#include <QtDebug>
 #include <random>
+#include <execution>
 #include <QSpinBox>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QToolButton>
+#include <QBoxLayout>
+#include <QMessageBox>
+
+#ifdef Q_OS_MACOS
+#include <QtConcurrent>
+#endif
+
+const char * RandomForestWorker::ValidationVariable = "FUZZYDROPLETS_VALIDATE_RANGER";
 
 RandomForestWorker::RandomForestWorker(Data * data)
     : m_data(data)
@@ -24,6 +38,12 @@ RandomForestWorker::~RandomForestWorker()
 
 void RandomForestWorker::go()
 {
+    if (!m_loadModelPath.isEmpty()) {
+        applyModel();
+        emit finished();
+        return;
+    }
+
     bool sourceIsFuzzy = false;
     for (auto source : m_sourceIndices) {
         if (!m_data->fuzzyColor(source).isFixed()) {
@@ -32,202 +52,288 @@ void RandomForestWorker::go()
         }
     }
 
-    std::string rangerPath = QDir::tempPath().toStdString();
-    if (rangerPath.ends_with('/'))
-        rangerPath.resize(rangerPath.size() - 1);
-
-    // step one, generate a forest from the data
-
-    m_numTrees = 1;
+    // step one, for fuzzy sources draw every label imputation up front. All imputations are grown as a
+    // single forest with the trees shared out between them, so averaging the forest's prediction averages
+    // over the imputations.
 
+    std::vector<std::vector<double>> imputations;
     if (sourceIsFuzzy) {
-
         std::random_device rd;
         std::mt19937 rng(rd());
         std::uniform_real_distribution<> dist(0.0, 1.0);
-        std::vector<FuzzyColor> cols(m_targetIndices.size(), FuzzyColor(m_data->colorComponentCount()));
-
-        for (int i = 0; i < 100; ++i) {
-
-            std::ofstream infile { rangerPath + "/ranger.txt"};
-            infile << "X Y target" << std::endl;
+        imputations.resize(std::min(ImputationCount, m_numTrees), std::vector<double>(m_sourceIndices.size()));
+        for (auto & imputation : imputations) {
+            size_t i = 0;
             for (auto source : m_sourceIndices) {
-                auto col = m_data->fuzzyColor(source);
+                const auto & col = m_data->fuzzyColor(source);
                 if (col.isFixed()) {
-                    infile << m_data->point(source).x() << " " << m_data->point(source).y() << " " << m_data->fuzzyColor(source).dominantComponent() << std::endl;
+                    imputation[i] = col.dominantComponent();
                 } else {
                     double p = dist(rng);
-                    int k = 0;
+                    size_t k = 0;
                     double pos = col.weight(0);
-                    while (pos < p) {
+                    while (pos < p && k + 1 < col.componentCount()) {
                         ++k;
                         pos += col.weight(k);
                     }
-                    infile << m_data->point(source).x() << " " << m_data->point(source).y() << " " << k << std::endl;
-                }
-            }
-            infile.close();
-
-            useRanger(rangerPath, false);
-            QFile f(QString::fromStdString(rangerPath) + "/ranger.prediction");
-            f.open(QFile::ReadOnly);
-            QTextStream ts(&f);
-            ts.readLine();
-            auto c = ts.readLine().split(" ", Qt::SkipEmptyParts);
-            QList<int> components;
-            for (auto & val : c) {
-                components.push_back(val.toInt());
-            }
-            ts.readLine();
-            int linePos = 0;
-            while (!ts.atEnd()) {
-                auto probs = ts.readLine().split(" ", Qt::SkipEmptyParts);
-                if (probs.size() == components.size()) {
-                    for (int k = 0; k < probs.size(); ++k) {
-                        cols[linePos].setWeight(components[k], cols[linePos].weight(components[k]) + probs[k].toDouble());
-                    }
-                    ++linePos;
-                    if (linePos == m_targetIndices.size()) break;
+                    imputation[i] = k;
                 }
+                ++i;
             }
-
-            emit updateProgress(100 * (double)i / 100);
         }
-        for (int i = 0; i < cols.size(); ++i) {
-            cols[i].normalize();
-            m_data->setColor(m_targetIndices[i], cols[i]);
-        }
-
+    }
 
+    std::vector<double> responses;
+    responses.reserve(m_sourceIndices.size());
+    for (auto source : m_sourceIndices)
+        responses.push_back(m_data->fuzzyColor(source).dominantComponent());
 
-    } else {
+    // step two, grow on the sources and set the averaged class probabilities of the targets
 
-        std::ofstream infile { rangerPath + "/ranger.txt"};
-        infile << "X Y target" << std::endl;
-        for (auto source : m_sourceIndices)
-            infile << m_data->point(source).x() << " " << m_data->point(source).y() << " " << m_data->fuzzyColor(source).dominantComponent() << std::endl;
-        infile.close();
-        useRanger(rangerPath, true);
-        QFile f(QString::fromStdString(rangerPath) + "/ranger.prediction");
-        f.open(QFile::ReadOnly);
-        QTextStream ts(&f);
-        ts.readLine();
-        auto c = ts.readLine().split(" ", Qt::SkipEmptyParts);
-        QList<int> components;
-        for (auto & val : c) {
-            components.push_back(val.toInt());
-        }
-        ts.readLine();
-        int i = 0;
-        while (!ts.atEnd()) {
-            auto probs = ts.readLine().split(" ", Qt::SkipEmptyParts);
-            if (probs.size() == components.size()) {
-                FuzzyColor col(m_data->colorComponentCount());
-                for (int k = 0; k < probs.size(); ++k) {
-                    col.setWeight(components[k], probs[k].toDouble());
-                }
-                m_data->setColor(m_targetIndices[i], col);
-                ++i;
-                if (i == m_targetIndices.size()) break;
-            }
+    std::vector<double> classValues;
+    auto probabilities = useRanger(ranger::MemoryMode::MEM_FLOAT, responses, imputations, classValues, 0, m_saveModelPath);
+    size_t i = 0;
+    for (auto target : m_targetIndices) {
+        FuzzyColor col(m_data->colorComponentCount());
+        for (size_t k = 0; k < classValues.size(); ++k) {
+            col.setWeight(classValues[k], probabilities[i][k]);
         }
+        if (sourceIsFuzzy)
+            col.normalize();
+        m_data->setColor(target, col);
+        ++i;
     }
 
+    if (qEnvironmentVariableIsSet(ValidationVariable))
+        validatePrecision(responses, imputations);
+
     emit finished();
 }
 
-void RandomForestWorker::useRanger(const std::string & rangerPath, bool connection)
+std::vector<std::vector<double>> RandomForestWorker::useRanger(ranger::MemoryMode memoryMode, const std::vector<double> & responses,
+                                                               const std::vector<std::vector<double>> & imputations,
+                                                               std::vector<double> & classValues, int seed, const QString & modelPath)
 {
-    // step one, grow trees
+    if (m_targetIndices.empty())
+        return {};
+
+    std::string logPath = QDir::tempPath().toStdString();
+    if (logPath.ends_with('/'))
+        logPath.resize(logPath.size() - 1);
+    std::ofstream logfile { logPath + "/ranger.log" };
+
+    std::vector<std::vector<double>> splitSelectWeights;
+    std::vector<double> caseWeights;
+    std::vector<std::vector<size_t>> manualInbag;
+    std::vector<double> sampleFraction { ranger::DEFAULT_SAMPLE_FRACTION_REPLACE };
+
+    // step one, grow trees on the sources and keep them for prediction, the training data is freed with the forest
+
+    std::vector<std::vector<std::vector<size_t>>> childNodeIDs;
+    std::vector<std::vector<size_t>> splitVarIDs;
+    std::vector<std::vector<double>> splitValues;
+    std::vector<std::vector<std::vector<double>>> terminalClassCounts;
+    std::vector<bool> isOrderedVariable;
+    size_t numTrees;
     {
     ranger::ForestProbability forest;
-    if (connection)
-        connect(&forest, &ranger::Forest::updateProgress, this, &RandomForestWorker::updateProgress);
-    std::ofstream logfile {  rangerPath + "/ranger.log" };
-    forest.initCpp("target", // dependent_variable_name
-                   ranger::MemoryMode::MEM_DOUBLE,  // memory mode
-                   rangerPath + "/ranger.txt",
-                   0, // mtry ***
-                   rangerPath + "/ranger", // output prefix
-                   m_numTrees, // num_trees,
-                   &logfile,
-                   0, // seed,
-                   QThread::idealThreadCount(), // num_threads,
-                   "", // load forest filename
-                   ranger::DEFAULT_IMPORTANCE_MODE, // importance mode
-                   ranger::DEFAULT_MIN_NODE_SIZE_CLASSIFICATION, // min_node_size,
-                   ranger::DEFAULT_MIN_BUCKET,//  min_bucket,
-                   "", //split_select_weights_file
-                   std::vector<std::string>(), // always_split_variable_names,
-                   "", // status_variable_name (only for survival)
-                   true, // bool sample_with_replacement,
-                   std::vector<std::string>(), //& unordered_variable_names,
-                   false, // bool memory_saving_splitting,
-                   ranger::DEFAULT_SPLITRULE, // SplitRule splitrule,
-                   "", // case_weights_file, only if holdout is true
-                   false, // bool predict_all,
-                   ranger::DEFAULT_SAMPLE_FRACTION_REPLACE, // or, NOREPLACE, double sample_fraction,
-                   ranger::DEFAULT_ALPHA, //double alpha,
-                   ranger::DEFAULT_MINPROP, // double minprop,
-                   false, // bool holdout,
-                   ranger::DEFAULT_PREDICTIONTYPE, //PredictionType prediction_type,
-                   ranger::DEFAULT_NUM_RANDOM_SPLITS, // uint num_random_splits,
-                   ranger::DEFAULT_MAXDEPTH, // uint max_depth,
-                   std::vector<double>(), // const std::vector<double>& regularization_factor,
-                   false); //bool regularization_usedepth
-    forest.run(true, true);
-    forest.saveToFile();
-    forest.writeOutput();
+    connect(&forest, &ranger::Forest::updateProgress, this, &RandomForestWorker::updateProgress);
+    forest.setImputedResponses(imputations);
+    forest.setHistogramBins(ranger::DEFAULT_HISTOGRAM_BINS);
+    forest.initR(rangerData(memoryMode, m_sourceIndices, responses),
+                 0, // mtry
+                 m_numTrees, // num_trees
+                 &logfile,
+                 seed, // seed, 0 for random
+                 QThread::idealThreadCount(), // num_threads
+                 ranger::DEFAULT_IMPORTANCE_MODE, // importance mode
+                 ranger::DEFAULT_MIN_NODE_SIZE_CLASSIFICATION, // min_node_size
+                 ranger::DEFAULT_MIN_BUCKET, // min_bucket
+                 splitSelectWeights,
+                 std::vector<std::string>(), // always_split_variable_names
+                 false, // prediction_mode
+                 true, // sample_with_replacement
+                 std::vector<std::string>(), // unordered_variable_names
+                 false, // memory_saving_splitting
+                 ranger::DEFAULT_SPLITRULE, // splitrule
+                 caseWeights,
+                 manualInbag,
+                 false, // predict_all
+                 false, // keep_inbag
+                 sampleFraction,
+                 ranger::DEFAULT_ALPHA, // alpha
+                 ranger::DEFAULT_MINPROP, // minprop
+                 false, // holdout
+                 ranger::DEFAULT_PREDICTIONTYPE, // prediction_type
+                 ranger::DEFAULT_NUM_RANDOM_SPLITS, // num_random_splits
+                 false, // order_snps
+                 ranger::DEFAULT_MAXDEPTH, // max_depth
+                 std::vector<double>(), // regularization_factor
+                 false, // regularization_usedepth
+                 false); // node_stats
+    forest.run(true, imputations.empty());
+    if (!modelPath.isEmpty()) {
+        try {
+            forest.saveModel(modelPath.toStdString());
+        } catch (const std::exception & e) {
+            emit failed("The forest could not be saved to the model registry: " + QString(e.what()));
+        }
     }
-
-    // step two, calc probabilities
-    {
-    std::ofstream infile { rangerPath + "/ranger.txt"};
-    infile << "X Y target" << std::endl;
-    for (auto target : m_targetIndices) {
-        infile << m_data->point(target).x() << " " << m_data->point(target).y() << " " << 1 << std::endl;
+    numTrees = forest.getNumTrees();
+    childNodeIDs = forest.getChildNodeIDs();
+    splitVarIDs = forest.getSplitVarIDs();
+    splitValues = forest.getSplitValues();
+    terminalClassCounts = forest.getTerminalClassCounts();
+    isOrderedVariable = forest.getIsOrderedVariable();
+    classValues = forest.getClassValues();
     }
-    infile.close();
-    std::ofstream logfile {  rangerPath + "/ranger.log" };
+
+    // step two, calc probabilities of the targets
+
     ranger::ForestProbability forest;
-    if (connection)
-        connect(&forest, &ranger::Forest::updateProgress, this, &RandomForestWorker::updateProgress);
-    forest.initCpp("target", // dependent_variable_name
-                   ranger::MemoryMode::MEM_DOUBLE,  // memory mode
-                   rangerPath + "/ranger.txt",
-                   0, // mtry ***
-                   rangerPath + "/ranger", // output prefix
-                   m_numTrees, // num_trees,
-                   &logfile,
-                   0, // seed,
-                   QThread::idealThreadCount(), // num_threads,
-                   rangerPath + "/ranger.forest", // load forest filename
-                   ranger::DEFAULT_IMPORTANCE_MODE, // importance mode
-                   ranger::DEFAULT_MIN_NODE_SIZE_CLASSIFICATION, // min_node_size,
-                   ranger::DEFAULT_MIN_BUCKET,//  min_bucket,
-                   "", //split_select_weights_file
-                   std::vector<std::string>(), // always_split_variable_names,
-                   "", // status_variable_name (only for survival)
-                   true, // bool sample_with_replacement,
-                   std::vector<std::string>(), //& unordered_variable_names,
-                   false, // bool memory_saving_splitting,
-                   ranger::DEFAULT_SPLITRULE, // SplitRule splitrule,
-                   "", // case_weights_file, only if holdout is true
-                   false, // bool predict_all,
-                   ranger::DEFAULT_SAMPLE_FRACTION_REPLACE, // or, NOREPLACE, double sample_fraction,
-                   ranger::DEFAULT_ALPHA, //double alpha,
-                   ranger::DEFAULT_MINPROP, // double minprop,
-                   false, // bool holdout,
-                   ranger::DEFAULT_PREDICTIONTYPE, //PredictionType prediction_type,
-                   ranger::DEFAULT_NUM_RANDOM_SPLITS, // uint num_random_splits,
-                   ranger::DEFAULT_MAXDEPTH, // uint max_depth,
-                   std::vector<double>(), // const std::vector<double>& regularization_factor,
-                   false); //bool regularization_usedepth
-    forest.run(true, true);
-    forest.saveToFile();
-    forest.writeOutput();
+    connect(&forest, &ranger::Forest::updateProgress, this, &RandomForestWorker::updateProgress);
+    forest.initR(rangerData(memoryMode, m_targetIndices, {}),
+                 0, // mtry
+                 numTrees, // num_trees
+                 &logfile,
+                 seed, // seed, 0 for random
+                 QThread::idealThreadCount(), // num_threads
+                 ranger::DEFAULT_IMPORTANCE_MODE, // importance mode
+                 ranger::DEFAULT_MIN_NODE_SIZE_CLASSIFICATION, // min_node_size
+                 ranger::DEFAULT_MIN_BUCKET, // min_bucket
+                 splitSelectWeights,
+                 std::vector<std::string>(), // always_split_variable_names
+                 true, // prediction_mode
+                 true, // sample_with_replacement
+                 std::vector<std::string>(), // unordered_variable_names
+                 false, // memory_saving_splitting
+                 ranger::DEFAULT_SPLITRULE, // splitrule
+                 caseWeights,
+                 manualInbag,
+                 false, // predict_all
+                 false, // keep_inbag
+                 sampleFraction,
+                 ranger::DEFAULT_ALPHA, // alpha
+                 ranger::DEFAULT_MINPROP, // minprop
+                 false, // holdout
+                 ranger::DEFAULT_PREDICTIONTYPE, // prediction_type
+                 ranger::DEFAULT_NUM_RANDOM_SPLITS, // num_random_splits
+                 false, // order_snps
+                 ranger::DEFAULT_MAXDEPTH, // max_depth
+                 std::vector<double>(), // regularization_factor
+                 false, // regularization_usedepth
+                 false); // node_stats
+    forest.loadForest(numTrees, childNodeIDs, splitVarIDs, splitValues, classValues, terminalClassCounts, isOrderedVariable);
+    forest.run(true, false);
+    return forest.getPredictions()[0];
+}
+
+template <typename RangerData, typename T>
+std::unique_ptr<ranger::Data> RandomForestWorker::copyRangerData(const IndexRanges & indices, const std::vector<double> & responses) const
+{
+    size_t n = indices.size();
+    std::vector<T> x(2 * n);
+    size_t i = 0;
+    for (auto index : indices) {
+        x[i] = m_data->point(index).x();
+        x[n + i] = m_data->point(index).y();
+        ++i;
     }
+    return std::make_unique<RangerData>(std::move(x), std::vector<T>(responses.begin(), responses.end()), std::vector<std::string> {"X", "Y"}, n, 2);
+}
 
+std::unique_ptr<ranger::Data> RandomForestWorker::rangerData(ranger::MemoryMode memoryMode, const IndexRanges & indices, const std::vector<double> & responses) const
+{
+    // droplet amplitudes in ranger's column major layout, stored as floats unless double precision is asked for
+    if (memoryMode == ranger::MemoryMode::MEM_DOUBLE)
+        return copyRangerData<ranger::DataDouble, double>(indices, responses);
+    return copyRangerData<ranger::DataFloat, float>(indices, responses);
+}
+
+void RandomForestWorker::validatePrecision(const std::vector<double> & responses, const std::vector<std::vector<double>> & imputations)
+{
+    // grow the same seeded forest from double and from float amplitudes and compare the target probabilities
+
+    std::vector<double> doubleClassValues;
+    std::vector<double> floatClassValues;
+    auto doubleProbabilities = useRanger(ranger::MemoryMode::MEM_DOUBLE, responses, imputations, doubleClassValues, ValidationSeed);
+    auto floatProbabilities = useRanger(ranger::MemoryMode::MEM_FLOAT, responses, imputations, floatClassValues, ValidationSeed);
+    if (doubleClassValues != floatClassValues || doubleProbabilities.size() != floatProbabilities.size()) {
+        qWarning() << "Ranger precision validation: float and double forests found different classes";
+        return;
+    }
+
+    double maxDifference = 0;
+    double sumDifference = 0;
+    size_t changedCount = 0;
+    for (size_t i = 0; i < doubleProbabilities.size(); ++i) {
+        const auto & d = doubleProbabilities[i];
+        const auto & f = floatProbabilities[i];
+        for (size_t k = 0; k < d.size(); ++k) {
+            double difference = std::abs(d[k] - f[k]);
+            maxDifference = std::max(maxDifference, difference);
+            sumDifference += difference;
+        }
+        if (std::max_element(d.begin(), d.end()) - d.begin() != std::max_element(f.begin(), f.end()) - f.begin())
+            ++changedCount;
+    }
+    qInfo() << "Ranger precision validation:" << doubleProbabilities.size() << "targets, max probability difference" << maxDifference
+            << "mean" << sumDifference / std::max<size_t>(1, doubleProbabilities.size() * doubleClassValues.size())
+            << "dominant class changed for" << changedCount;
+}
+
+void RandomForestWorker::applyModel()
+{
+    // the model file is mapped and predicted from in place, no forest is grown or parsed
+
+    PhyloGenerics::MappedFile file(m_loadModelPath.toStdString());
+    if (!file.isValid()) {
+        emit failed("Could not open the model file " + m_loadModelPath + ".");
+        return;
+    }
+    std::unique_ptr<ranger::ForestModel> model;
+    try {
+        model = std::make_unique<ranger::ForestModel>(file.data(), file.size());
+    } catch (const std::exception & e) {
+        emit failed("The model file " + m_loadModelPath + " is not a valid forest model: " + QString(e.what()));
+        return;
+    }
+    if (model->getNumVariables() != 2) {
+        emit failed("The model file " + m_loadModelPath + " was not trained on droplet amplitudes.");
+        return;
+    }
+
+    auto targetBlocks = m_targetIndices.blocks(ModelBlockSize);
+    std::atomic<size_t> done = 0;
+    std::atomic<int> percent = 0;
+#ifndef Q_OS_MACOS
+    std::for_each(std::execution::par, targetBlocks.begin(), targetBlocks.end(), [&](const IndexRanges::Range & block) {
+#else
+    QtConcurrent::blockingMap(targetBlocks.begin(), targetBlocks.end(), [&](const IndexRanges::Range & block) {
+#endif
+        if (m_cancel)
+            return;
+        std::vector<double> probabilities(model->getNumClasses());
+        for (size_t target = block[0]; target < block[1]; ++target) {
+            const double sample[2] = {m_data->point(target).x(), m_data->point(target).y()};
+            model->predict(sample, probabilities.data());
+            FuzzyColor col(m_data->colorComponentCount());
+            for (size_t k = 0; k < probabilities.size(); ++k) {
+                size_t component = model->getClassValues()[k];
+                if (component < col.componentCount())
+                    col.setWeight(component, probabilities[k]);
+            }
+            if (col.totalWeight() > 0)
+                col.normalize();
+            m_data->setColor(target, col);
+        }
+
+        int newPercent = int(100 * ++done / targetBlocks.size());
+        int oldPercent = percent;
+        while (newPercent > oldPercent && !percent.compare_exchange_weak(oldPercent, newPercent)) {}
+        if (newPercent > oldPercent)
+            emit updateProgress(newPercent);
+    });
 }
 
 void RandomForestWorker::cancel()
@@ -246,23 +352,87 @@ RandomForestWidget::RandomForestWidget(Data * data, QWidget * parent)
     m_numTreesSpinBox->setValue(500);
     m_numTreesSpinBox->setSingleStep(50);
     form->addRow("Number of Trees", m_numTreesSpinBox);
+
+    m_modelComboBox = new QComboBox;
+    m_removeModelButton = new QToolButton;
+    m_removeModelButton->setIcon(themedIcon(":/exit"));
+    m_removeModelButton->setToolTip("Remove the selected model");
+    QHBoxLayout * modelLayout = new QHBoxLayout;
+    modelLayout->setContentsMargins(0,0,0,0);
+    modelLayout->addWidget(m_modelComboBox, 1);
+    modelLayout->addWidget(m_removeModelButton);
+    form->addRow("Model", modelLayout);
+
+    m_saveModelLineEdit = new QLineEdit;
+    m_saveModelLineEdit->setPlaceholderText("Do not save");
+    form->addRow("Save Model As", m_saveModelLineEdit);
     setLayout(form);
+
+    connect(m_modelComboBox, &QComboBox::currentIndexChanged, this, &RandomForestWidget::modelSelectionChanged);
+    connect(m_removeModelButton, &QToolButton::clicked, this, &RandomForestWidget::removeSelectedModel);
+    refreshModels();
+}
+
+void RandomForestWidget::refreshModels()
+{
+    QString current = m_modelComboBox->currentData().toString();
+    m_modelComboBox->blockSignals(true);
+    m_modelComboBox->clear();
+    m_modelComboBox->addItem("Train New Forest");
+    for (auto & name : m_registry.modelNames())
+        m_modelComboBox->addItem(name, name);
+    m_modelComboBox->setCurrentIndex(std::max(0, m_modelComboBox->findData(current)));
+    m_modelComboBox->blockSignals(false);
+    modelSelectionChanged();
 }
 
-void RandomForestWidget::run(const QList<size_t> & sourceIndices, const QList<size_t> & targetIndices)
+void RandomForestWidget::modelSelectionChanged()
+{
+    bool training = m_modelComboBox->currentIndex() == 0;
+    m_numTreesSpinBox->setEnabled(training);
+    m_saveModelLineEdit->setEnabled(training);
+    m_removeModelButton->setEnabled(!training);
+}
+
+void RandomForestWidget::removeSelectedModel()
+{
+    QString name = m_modelComboBox->currentData().toString();
+    if (name.isEmpty())
+        return;
+    if (QMessageBox::question(this, "Remove Model?", "Remove the model \"" + name + "\" from the registry?") == QMessageBox::Yes) {
+        m_registry.removeModel(name);
+        refreshModels();
+    }
+}
+
+void RandomForestWidget::run(const IndexRanges & sourceIndices, const IndexRanges & targetIndices)
 {
     if (!assignmentWorkerThread) {
+        QString loadPath;
+        QString savePath;
+        if (m_modelComboBox->currentIndex() > 0) {
+            loadPath = m_registry.modelPath(m_modelComboBox->currentData().toString());
+        } else if (!m_saveModelLineEdit->text().trimmed().isEmpty()) {
+            QString name = m_saveModelLineEdit->text().trimmed();
+            if (!ModelRegistry::isValidName(name)) {
+                QMessageBox::information(this, "Invalid Model Name", "Model names cannot start with a period or contain any of / \\ : * ? \" < > |");
+                return;
+            }
+            savePath = m_registry.modelPath(name);
+        }
         emit beginAssignment();
         setEnabled(false);
         assignmentWorkerThread = new QThread;
         RandomForestWorker * worker = new RandomForestWorker(m_data);
         worker->setParams(m_numTreesSpinBox->value(), sourceIndices, targetIndices);
+        worker->setModelPaths(loadPath, savePath);
         worker->moveToThread(assignmentWorkerThread);
         connect(this, &RandomForestWidget::startAssignment, worker, &RandomForestWorker::go);
         connect(worker, &RandomForestWorker::finished, this, &RandomForestWidget::assignmentThreadFinished);
         connect(worker, &RandomForestWorker::updateProgress, this, &RandomForestWidget::updateProgress);
+        connect(worker, &RandomForestWorker::failed, this, &RandomForestWidget::assignmentFailed);
         connect(assignmentWorkerThread, &QThread::finished, worker, &QObject::deleteLater);
-        connect(this, &RandomForestWidget::cancelAssignment, worker, &RandomForestWorker::cancel);
+        connect(this, &RandomForestWidget::cancelAssignment, worker, &RandomForestWorker::cancel, Qt::DirectConnection);
         assignmentWorkerThread->start();
         emit startAssignment();
     }
@@ -283,5 +453,14 @@ void RandomForestWidget::assignmentThreadFinished()
         assignmentWorkerThread = nullptr;
         emit endAssignment();
         setEnabled(true);
+        if (!m_saveModelLineEdit->text().trimmed().isEmpty()) {
+            m_saveModelLineEdit->clear();
+            refreshModels();
+        }
     }
 }
+
+void RandomForestWidget::assignmentFailed(const QString & message)
+{
+    QMessageBox::information(this, "Random Forest", message);
+}
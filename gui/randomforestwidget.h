@@ -2,9 +2,20 @@
 #define RANDOMFORESTWIDGET_H
 
 #include "assignmentmethodwidget.h"
+#include "../core/modelregistry.h"
+#include "../ranger/globals.h"
+#include <atomic>
+#include <memory>
+
+namespace ranger {
+class Data;
+}
 
 class Data;
 class QSpinBox;
+class QComboBox;
+class QLineEdit;
+class QToolButton;
 
 class RandomForestWorker : public QObject
 {
@@ -16,25 +27,47 @@ public:
     ~RandomForestWorker();
 
     void go();
-    void cancel();
-    void setParams(int numTrees, const QList<size_t> & source, const QList<size_t> & target) {m_numTrees = numTrees; m_sourceIndices = source; m_targetIndices = target;}
+    void cancel();                  // thread safe, connect directly
+    void setParams(int numTrees, const IndexRanges & source, const IndexRanges & target) {m_numTrees = numTrees; m_sourceIndices = source; m_targetIndices = target;}
+    void setModelPaths(const QString & loadPath, const QString & savePath) {m_loadModelPath = loadPath; m_saveModelPath = savePath;}
+
+    // Grows a forest on the sources and returns the class probabilities of the targets, ordered as classValues
+    std::vector<std::vector<double>> useRanger(ranger::MemoryMode memoryMode, const std::vector<double> & responses,
+                                               const std::vector<std::vector<double>> & imputations,
+                                               std::vector<double> & classValues, int seed = 0, const QString & modelPath = QString());
+    void applyModel();
 
-    void useRanger(const std::string & rangerPath, bool connect);
+    // Compares float and double forests on the current sources and targets, run after each assignment when
+    // the ValidationVariable environment variable is set
+    void validatePrecision(const std::vector<double> & responses, const std::vector<std::vector<double>> & imputations);
+
+    static const char * ValidationVariable;
 
 signals:
 
     void finished();
     void updateProgress(int);
+    void failed(const QString & message);
 
 private:
 
+    std::unique_ptr<ranger::Data> rangerData(ranger::MemoryMode memoryMode, const IndexRanges & indices, const std::vector<double> & responses) const;
+    template <typename RangerData, typename T>
+    std::unique_ptr<ranger::Data> copyRangerData(const IndexRanges & indices, const std::vector<double> & responses) const;
+
     Data * m_data;
-    QList<size_t> m_sourceIndices;
-    QList<size_t> m_targetIndices;
+    IndexRanges m_sourceIndices;
+    IndexRanges m_targetIndices;
     size_t m_iterStart {0};
     int m_percent {0};
-    bool m_cancel {false};
+    std::atomic<bool> m_cancel {false};
     int m_numTrees;
+    QString m_loadModelPath;
+    QString m_saveModelPath;
+
+    static const int ImputationCount = 100;
+    static const size_t ModelBlockSize = 1024;     // targets predicted per parallel step of a saved model
+    static const int ValidationSeed = 1;
 };
 
 class RandomForestWidget : public AssignmentMethodWidget
@@ -47,7 +80,7 @@ public:
 
     virtual bool providesProgressUpdates() const {return true;}
     virtual bool canCancel() const {return true;}
-    virtual void run(const QList<size_t> & sourceIndices, const QList<size_t> & targetIndices);
+    virtual void run(const IndexRanges & sourceIndices, const IndexRanges & targetIndices);
     virtual void cancel();
 
 signals:
@@ -57,12 +90,24 @@ signals:
 public slots:
 
     void assignmentThreadFinished();
+    void assignmentFailed(const QString & message);
+
+private slots:
+
+    void modelSelectionChanged();
+    void removeSelectedModel();
 
 private:
 
+    void refreshModels();
+
     Data * m_data;
     QThread * assignmentWorkerThread {nullptr};
     QSpinBox * m_numTreesSpinBox;
+    QComboBox * m_modelComboBox;
+    QToolButton * m_removeModelButton;
+    QLineEdit * m_saveModelLineEdit;
+    ModelRegistry m_registry;
 };
 
 #endif // RANDOMFORESTWIDGET_H
@@ -10,6 +10,7 @@
 #include "generic/comboboxitemdelegate.h"
 #include "generic/nofocusitemdelegate.h"
 #include "generic/commandstack.h"
+#include "samplethumbnails.h"
 #include <QTemporaryFile>
 #include <QTextStream>
 #include <execution>
@@ -55,6 +56,7 @@ SampleListWidget::SampleListWidget(Data * data, CommandStack * commandStack, QWi
 
     // set up the rows
     m_tableWidget->verticalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_tableWidget->setIconSize(QSize(SampleThumbnails::ThumbnailSize, SampleThumbnails::ThumbnailSize));   // each sample shows a thumbnail of its droplets
 
     // set up the columns
     m_tableWidget->setColumnCount(3);                                                                   // we have three columns
@@ -83,6 +85,10 @@ SampleListWidget::SampleListWidget(Data * data, CommandStack * commandStack, QWi
     connect(data, &Data::samplesAdded, this, &SampleListWidget::samplesAdded);
     connect(data, &Data::selectedSamplesChanged, this, &SampleListWidget::selectedSamplesChanged);
     connect(data, &Data::sampleTypesChanged, this, &SampleListWidget::sampleTypesChanged);
+
+    // thumbnails are drawn in the background and set as the icons of the sample names
+    m_thumbnails = new SampleThumbnails(data, this);
+    connect(m_thumbnails, &SampleThumbnails::thumbnailsChanged, this, &SampleListWidget::thumbnailsChanged);
 }
 
 SampleListWidget::~SampleListWidget()
@@ -204,6 +210,15 @@ void SampleListWidget::samplesAdded(std::vector<size_t> samples)
     m_tableWidget->sortByColumn(sortSection, sortOrder);
 }
 
+void SampleListWidget::thumbnailsChanged(std::vector<size_t> samples)
+{
+    for (auto sample : samples) {
+        auto row = rowFromSample(sample);
+        if (row >= 0)
+            m_tableWidget->item(row, 0)->setIcon(QIcon(QPixmap::fromImage(m_thumbnails->thumbnail(sample))));
+    }
+}
+
 void SampleListWidget::showContextMenu(const QPoint& pos)
 {
     QTableWidgetItem * item = m_tableWidget->itemAt(pos);
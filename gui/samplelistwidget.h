@@ -8,6 +8,7 @@
 
 class QTableWidget;
 class CommandStack;
+class SampleThumbnails;
 
 class SampleListWidget : public QWidget
 {
@@ -53,6 +54,7 @@ public slots:
     void selectedSamplesChanged();
     void sampleTypesChanged(std::vector<size_t> samples);
     void samplesAdded(std::vector<size_t> samples);
+    void thumbnailsChanged(std::vector<size_t> samples);
     void invertSelection();
     void selectAll();
     void selectExperimentalSamples();
@@ -69,6 +71,7 @@ private:
 
     Data * m_data;
     QTableWidget * m_tableWidget;
+    SampleThumbnails * m_thumbnails;
     QMap<Data::SampleType, QString> m_dataTypeToLabel;
 
     CommandStack * m_commandStack;
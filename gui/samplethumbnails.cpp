@@ -0,0 +1,173 @@
+#include "samplethumbnails.h"
+#include "../core/data.h"
+#include <QThread>
+#include <QTimer>
+#include <cmath>
+#include <execution>
+#include <numeric>
+#include <ranges>
+
+#ifdef Q_OS_MACOS
+#include <QtConcurrent>
+#endif
+
+SampleThumbnails::SampleThumbnails(Data * data, QObject * parent)
+    : QObject(parent),
+    m_data(data)
+{
+    m_renderThread = new QThread;
+    m_renderer = new SampleThumbnailRenderer(this);
+    m_renderer->moveToThread(m_renderThread);
+    connect(this, &SampleThumbnails::renderRequested, m_renderer, &SampleThumbnailRenderer::render);
+    connect(m_renderer, &SampleThumbnailRenderer::thumbnailsReady, this, &SampleThumbnails::collectThumbnails);
+    m_renderThread->start();
+
+    connect(m_data, &Data::storageAboutToChange, this, &SampleThumbnails::stopRendering);
+    connect(m_data, &Data::colorsAboutToChange, this, &SampleThumbnails::stopRendering);
+    connect(m_data, &Data::samplesAdded, this, &SampleThumbnails::refreshAll);
+
+    m_pollTimer = new QTimer(this);
+    connect(m_pollTimer, &QTimer::timeout, this, &SampleThumbnails::pollColorChanges);
+    m_pollTimer->start(PollInterval);
+}
+
+SampleThumbnails::~SampleThumbnails()
+{
+    stopRendering();
+    m_renderThread->quit();
+    m_renderThread->wait();
+    delete m_renderer;
+    delete m_renderThread;
+}
+
+void SampleThumbnails::refresh(std::vector<size_t> samples)
+{
+    if (samples.empty()) return;
+    {
+        QMutexLocker locker(&m_jobMutex);
+        for (auto sample : samples)
+            m_jobs.push_back({sample, m_data->bounds(), m_generation});
+    }
+    emit renderRequested();
+}
+
+void SampleThumbnails::refreshAll()
+{
+    m_data->colorChangesSince(m_colorRevision);
+    std::vector<size_t> samples(m_data->sampleCount());
+    std::iota(samples.begin(), samples.end(), 0);
+    refresh(samples);
+}
+
+void SampleThumbnails::stopRendering()
+{
+    ++m_generation;
+    {
+        QMutexLocker locker(&m_jobMutex);
+        m_jobs.clear();
+        m_results.clear();
+    }
+    QMutexLocker locker(&m_renderMutex);    // returns once the renderer has left the data
+}
+
+void SampleThumbnails::pollColorChanges()
+{
+    if (m_data->sampleCount() == 0) return;
+    auto changes = m_data->colorChangesSince(m_colorRevision);
+    if (changes.all) {
+        std::vector<size_t> samples(m_data->sampleCount());
+        std::iota(samples.begin(), samples.end(), 0);
+        refresh(samples);
+    } else {
+        refresh(changes.samples);
+    }
+}
+
+void SampleThumbnails::collectThumbnails()
+{
+    std::vector<std::pair<Job, QImage>> results;
+    {
+        QMutexLocker locker(&m_jobMutex);
+        results.swap(m_results);
+    }
+    std::vector<size_t> changed;
+    for (auto & [job, image] : results) {
+        if (job.generation != m_generation || job.sample >= m_data->sampleCount()) continue;
+        if (m_thumbnails.size() < m_data->sampleCount())
+            m_thumbnails.resize(m_data->sampleCount());
+        m_thumbnails[job.sample] = std::move(image);
+        changed.push_back(job.sample);
+    }
+    if (!changed.empty())
+        emit thumbnailsChanged(changed);
+}
+
+// bins the droplets of the sample into pixels over bounds, each pixel shows the mean colour of its droplets with
+// an alpha that grows with the log of their count
+QImage SampleThumbnails::renderThumbnail(size_t sample, const OrthogonalRectangle & bounds) const
+{
+    QImage image(ThumbnailSize, ThumbnailSize, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+    if (bounds.width() <= 0 || bounds.height() <= 0) return image;
+
+    std::vector<std::array<unsigned int, 4>> sums(ThumbnailSize * ThumbnailSize, {0, 0, 0, 0});
+    auto range = m_data->sampleIndices(sample);
+    double xScale = ThumbnailSize / bounds.width();
+    double yScale = ThumbnailSize / bounds.height();
+    for (size_t i = range[0]; i < range[1]; ++i) {
+        const auto & pt = m_data->point(i);
+        int x = std::clamp(int((pt.x() - bounds.left()) * xScale), 0, ThumbnailSize - 1);
+        int y = std::clamp(int((bounds.top() - pt.y()) * yScale), 0, ThumbnailSize - 1);
+        auto rgb = m_data->rgba(i);
+        auto & sum = sums[y * ThumbnailSize + x];
+        sum[0] += Color::red(rgb);
+        sum[1] += Color::green(rgb);
+        sum[2] += Color::blue(rgb);
+        ++sum[3];
+    }
+
+    auto maxCount = std::ranges::max(sums, {}, [](const auto & sum) {return sum[3];})[3];
+    if (maxCount == 0) return image;
+    double logMax = std::log1p(maxCount);
+    QRgb * pixels = reinterpret_cast<QRgb*>(image.bits());
+    for (size_t p = 0; p < sums.size(); ++p) {
+        const auto & sum = sums[p];
+        if (sum[3] > 0)
+            pixels[p] = Color::rgba(sum[0] / sum[3], sum[1] / sum[3], sum[2] / sum[3], MinAlpha + int(std::round((255 - MinAlpha) * std::log1p(sum[3]) / logMax)));
+    }
+    return image;
+}
+
+void SampleThumbnailRenderer::render()
+{
+    std::vector<SampleThumbnails::Job> jobs;
+    {
+        QMutexLocker locker(&m_thumbnails->m_jobMutex);
+        jobs.swap(m_thumbnails->m_jobs);
+    }
+    std::erase_if(jobs, [&](const auto & job) {return job.generation != m_thumbnails->m_generation;});
+    if (jobs.empty()) return;
+
+    std::vector<QImage> images(jobs.size());
+    {
+        QMutexLocker locker(&m_thumbnails->m_renderMutex);
+#ifndef Q_OS_MACOS
+        auto iota = std::ranges::views::iota((size_t)0, jobs.size());
+        std::for_each(std::execution::par, iota.begin(), iota.end(), [&](size_t i) {
+#else
+        QList<size_t> iota(jobs.size(), 0);
+        std::iota(iota.begin(), iota.end(), 0);
+        QtConcurrent::blockingMap(iota.begin(), iota.end(), [&](const size_t & i) {
+#endif
+            if (jobs[i].generation == m_thumbnails->m_generation && jobs[i].sample < m_thumbnails->m_data->sampleCount())
+                images[i] = m_thumbnails->renderThumbnail(jobs[i].sample, jobs[i].bounds);
+        });
+    }
+
+    {
+        QMutexLocker locker(&m_thumbnails->m_jobMutex);
+        for (size_t i = 0; i < jobs.size(); ++i)
+            m_thumbnails->m_results.emplace_back(jobs[i], std::move(images[i]));
+    }
+    emit thumbnailsReady();
+}
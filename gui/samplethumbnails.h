@@ -0,0 +1,100 @@
+#ifndef FUZZYDROPLETS_GUI_SAMPLETHUMBNAILS_H
+#define FUZZYDROPLETS_GUI_SAMPLETHUMBNAILS_H
+
+#include "../core/geometry.h"
+#include <QImage>
+#include <QObject>
+#include <QMutex>
+#include <atomic>
+#include <vector>
+
+class Data;
+class QThread;
+class QTimer;
+class SampleThumbnails;
+
+// renders the thumbnails SampleThumbnails asks for, on its own thread
+class SampleThumbnailRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    SampleThumbnailRenderer(SampleThumbnails * thumbnails) : m_thumbnails(thumbnails) {}
+
+    void render();
+
+signals:
+
+    void thumbnailsReady();
+
+private:
+
+    SampleThumbnails * m_thumbnails;
+};
+
+// small density images of every sample, drawn straight from each sample's droplet range over the bounds of all
+// the data so they can be compared at a glance. They are cached and only the samples whose colours changed are
+// drawn again.
+class SampleThumbnails : public QObject
+{
+    Q_OBJECT
+
+    friend class SampleThumbnailRenderer;
+
+public:
+
+    SampleThumbnails(Data * data, QObject * parent = nullptr);
+    ~SampleThumbnails();
+
+    const QImage & thumbnail(size_t sample) const {static const QImage null; return sample < m_thumbnails.size() ? m_thumbnails[sample] : null;}
+
+    static const int ThumbnailSize = 48;
+
+public slots:
+
+    void refresh(std::vector<size_t> samples);
+    void refreshAll();
+    void stopRendering();           // cancels queued thumbnails and waits for the renderer, call before the data's storage changes
+
+signals:
+
+    void renderRequested();
+    void thumbnailsChanged(std::vector<size_t> samples);
+
+private slots:
+
+    void pollColorChanges();
+    void collectThumbnails();
+
+private:
+
+    struct Job
+    {
+        size_t sample;
+        OrthogonalRectangle bounds;
+        size_t generation;
+    };
+
+    QImage renderThumbnail(size_t sample, const OrthogonalRectangle & bounds) const;
+
+    static const int MinAlpha = 64;
+    static const int PollInterval = 500;    // milliseconds between checks for recoloured samples
+
+    Data * m_data;
+    std::vector<QImage> m_thumbnails;
+    size_t m_colorRevision {0};
+    QTimer * m_pollTimer;
+
+    // jobs and results are guarded by m_jobMutex and the renderer holds m_renderMutex while it reads the data.
+    // Jobs and results of an older generation are dropped.
+    QThread * m_renderThread;
+    SampleThumbnailRenderer * m_renderer;
+    std::atomic<size_t> m_generation {0};
+    std::vector<Job> m_jobs;
+    std::vector<std::pair<Job, QImage>> m_results;
+    QMutex m_jobMutex;
+    QMutex m_renderMutex;
+};
+
+#endif // FUZZYDROPLETS_GUI_SAMPLETHUMBNAILS_H
@@ -22,7 +22,7 @@ namespace ranger {
 
 Data::Data() :
     num_rows(0), num_rows_rounded(0), num_cols(0), snp_data(0), num_cols_no_snp(0), externalData(true), index_data(0), max_num_unique_values(
-        0), order_snps(false) {
+        0), max_num_bins(0), order_snps(false) {
 }
 
 size_t Data::getVariableID(const std::string& variable_name) const {
@@ -280,6 +280,50 @@ void Data::sort() {
   }
 }
 
+void Data::binData(uint max_bins) {
+
+  max_bins = std::max(2u, std::min(max_bins, (uint) UINT16_MAX));
+  bin_data.resize(num_cols_no_snp * num_rows);
+  bin_lower_values.assign(num_cols_no_snp, std::vector<double>());
+  bin_upper_values.assign(num_cols_no_snp, std::vector<double>());
+  max_num_bins = 0;
+
+  // Every bin but the last closes once it holds more than num_rows / max_bins samples
+  size_t bin_size = num_rows / max_bins + 1;
+  for (size_t col = 0; col < num_cols_no_snp; ++col) {
+    const std::vector<double>& unique_values = unique_data_values[col];
+
+    // Count samples per unique value
+    std::vector<size_t> counts(unique_values.size(), 0);
+    for (size_t row = 0; row < num_rows; ++row) {
+      ++counts[index_data[col * num_rows + row]];
+    }
+
+    // Assign consecutive unique values to bins, one each if there are few enough
+    std::vector<uint16_t> unique_bins(unique_values.size());
+    size_t num_in_bin = 0;
+    for (size_t i = 0; i < unique_values.size(); ++i) {
+      if (num_in_bin == 0) {
+        bin_lower_values[col].push_back(unique_values[i]);
+      }
+      unique_bins[i] = bin_lower_values[col].size() - 1;
+      num_in_bin += counts[i];
+      if (unique_values.size() <= max_bins || num_in_bin >= bin_size || i + 1 == unique_values.size()) {
+        bin_upper_values[col].push_back(unique_values[i]);
+        num_in_bin = 0;
+      }
+    }
+
+    for (size_t row = 0; row < num_rows; ++row) {
+      bin_data[col * num_rows + row] = unique_bins[index_data[col * num_rows + row]];
+    }
+
+    if (bin_lower_values[col].size() > max_num_bins) {
+      max_num_bins = bin_lower_values[col].size();
+    }
+  }
+}
+
 // TODO: Implement ordering for multiclass and survival
 // #nocov start (cannot be tested anymore because GenABEL not on CRAN)
 void Data::orderSnpLevels(bool corrected_importance) {
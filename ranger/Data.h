@@ -13,6 +13,7 @@
 #define DATA_H_
 
 #include <vector>
+#include <cstdint>
 #include <iostream>
 #include <numeric>
 #include <random>
@@ -123,6 +124,35 @@ public:
 
   void sort();
 
+  // Pre-bin sorted data into at most max_bins bins of about equal size per variable, for histogram splitting
+  void binData(uint max_bins);
+
+  size_t getBin(size_t row, size_t col) const {
+    return bin_data[col * num_rows + row];
+  }
+
+  size_t getNumBins(size_t varID) const {
+    return bin_lower_values[varID].size();
+  }
+
+  size_t getMaxNumBins() const {
+    return max_num_bins;
+  }
+
+  // Columns binned by binData, the SNP columns are not
+  size_t getNumBinnedCols() const {
+    return bin_lower_values.size();
+  }
+
+  // Smallest and largest data value in a bin
+  double getBinLowerValue(size_t varID, size_t bin) const {
+    return bin_lower_values[varID][bin];
+  }
+
+  double getBinUpperValue(size_t varID, size_t bin) const {
+    return bin_upper_values[varID][bin];
+  }
+
   void orderSnpLevels(bool corrected_importance);
 
   const std::vector<std::string>& getVariableNames() const {
@@ -212,6 +242,12 @@ protected:
   std::vector<std::vector<double>> unique_data_values;
   size_t max_num_unique_values;
 
+  // Binned data for histogram splitting
+  std::vector<uint16_t> bin_data;
+  std::vector<std::vector<double>> bin_lower_values;
+  std::vector<std::vector<double>> bin_upper_values;
+  size_t max_num_bins;
+
   // For each varID true if ordered
   std::vector<bool> is_ordered_variable;
 
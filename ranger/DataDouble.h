@@ -16,6 +16,8 @@
 
 #include <vector>
 #include <utility>
+#include <string>
+#include <stdexcept>
 
 #include "globals.h"
 #include "utility.h"
@@ -26,6 +28,19 @@ namespace ranger {
 class DataDouble: public Data {
 public:
   DataDouble() = default;
+
+  // In memory data, x holds num_cols and y any number of columns of num_rows values each, column major
+  DataDouble(std::vector<double> x, std::vector<double> y, std::vector<std::string> variable_names, size_t num_rows, size_t num_cols) :
+      x(std::move(x)), y(std::move(y)) {
+    if (this->x.size() != num_rows * num_cols || variable_names.size() != num_cols
+        || (num_rows > 0 && this->y.size() % num_rows != 0)) {
+      throw std::runtime_error("Size of data does not match number of rows and columns.");
+    }
+    this->variable_names = std::move(variable_names);
+    this->num_rows = num_rows;
+    this->num_cols = num_cols;
+    this->num_cols_no_snp = num_cols;
+  }
   
   DataDouble(const DataDouble&) = delete;
   DataDouble& operator=(const DataDouble&) = delete;
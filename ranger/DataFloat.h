@@ -16,6 +16,8 @@
 
 #include <vector>
 #include <utility>
+#include <string>
+#include <stdexcept>
 
 #include "globals.h"
 #include "utility.h"
@@ -27,6 +29,19 @@ class DataFloat: public Data {
 public:
   DataFloat() = default;
 
+  // In memory data, x holds num_cols and y any number of columns of num_rows values each, column major
+  DataFloat(std::vector<float> x, std::vector<float> y, std::vector<std::string> variable_names, size_t num_rows, size_t num_cols) :
+      x(std::move(x)), y(std::move(y)) {
+    if (this->x.size() != num_rows * num_cols || variable_names.size() != num_cols
+        || (num_rows > 0 && this->y.size() % num_rows != 0)) {
+      throw std::runtime_error("Size of data does not match number of rows and columns.");
+    }
+    this->variable_names = std::move(variable_names);
+    this->num_rows = num_rows;
+    this->num_cols = num_cols;
+    this->num_cols_no_snp = num_cols;
+  }
+
   DataFloat(const DataFloat&) = delete;
   DataFloat& operator=(const DataFloat&) = delete;
 
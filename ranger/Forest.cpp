@@ -448,6 +448,12 @@ void Forest::grow() {
   // Call special grow functions of subclasses. There trees must be created.
   growInternal();
 
+  // Histograms need the sorted data and are not implemented for corrected impurity importance
+  bool histogram_splitting = histogram_bins > 0 && !memory_saving_splitting && importance_mode != IMP_GINI_CORRECTED;
+  if (histogram_splitting) {
+    data->binData(histogram_bins);
+  }
+
   // Init trees, create a seed for each tree, based on main seed
   std::uniform_int_distribution<uint> udist;
   for (size_t i = 0; i < num_trees; ++i) {
@@ -478,6 +484,7 @@ void Forest::grow() {
         importance_mode, min_node_size, min_bucket, sample_with_replacement, memory_saving_splitting, splitrule, &case_weights,
         tree_manual_inbag, keep_inbag, &sample_fraction, alpha, minprop, holdout, num_random_splits, max_depth,
         &regularization_factor, regularization_usedepth, &split_varIDs_used, save_node_stats);
+    trees[i]->setHistogramSplitting(histogram_splitting);
   }
 
   // Init variable importance
@@ -541,11 +548,21 @@ void Forest::predict() {
   aborted_threads = 0;
 #endif
 
-  // Predict
+  // Compile trees to packed nodes, only possible if all split variables are ordered
+  bool packed = true;
+  for (auto& tree : trees) {
+    packed = tree->pack(data.get()) && packed;
+  }
+
+  // Predict, blocks of samples through all trees of a thread if packed
   std::vector<std::thread> threads;
   threads.reserve(num_threads);
   for (uint i = 0; i < num_threads; ++i) {
-    threads.emplace_back(&Forest::predictTreesInThread, this, i, data.get(), false);
+    if (packed) {
+      threads.emplace_back(&Forest::predictTreeBlocksInThread, this, i, data.get());
+    } else {
+      threads.emplace_back(&Forest::predictTreesInThread, this, i, data.get(), false);
+    }
   }
   showProgress("Predicting..", num_trees);
   for (auto &thread : threads) {
@@ -733,6 +750,60 @@ void Forest::predictTreesInThread(uint thread_idx, const Data* prediction_data,
   }
 }
 
+void Forest::predictTreeBlocksInThread(uint thread_idx, const Data* prediction_data) {
+  if (thread_ranges.size() > thread_idx + 1) {
+    size_t first_tree = thread_ranges[thread_idx];
+    size_t num_thread_trees = thread_ranges[thread_idx + 1] - first_tree;
+    size_t num_rows = prediction_data->getNumRows();
+    size_t num_cols = prediction_data->getNumCols();
+    for (size_t i = first_tree; i < first_tree + num_thread_trees; ++i) {
+      trees[i]->allocatePredictionMemory(num_rows);
+    }
+
+    // Gather each block of samples once, then drop it down every tree of this thread
+    std::vector<double> block(PREDICTION_BLOCK_SIZE * num_cols);
+    size_t num_blocks = (num_rows + PREDICTION_BLOCK_SIZE - 1) / PREDICTION_BLOCK_SIZE;
+    size_t reported = 0;
+    for (size_t b = 0; b < num_blocks; ++b) {
+      size_t begin = b * PREDICTION_BLOCK_SIZE;
+      size_t end = std::min(begin + (size_t) PREDICTION_BLOCK_SIZE, num_rows);
+      for (size_t row = begin; row < end; ++row) {
+        for (size_t col = 0; col < num_cols; ++col) {
+          block[(row - begin) * num_cols + col] = prediction_data->get_x(row, col);
+        }
+      }
+      for (size_t i = first_tree; i < first_tree + num_thread_trees; ++i) {
+        trees[i]->predictBlock(block.data(), num_cols, begin, end);
+      }
+
+      // Check for user interrupt
+#ifdef R_BUILD
+      if (aborted) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++aborted_threads;
+        condition_variable.notify_one();
+        return;
+      }
+#endif
+
+      // Increase progress by the share of trees done
+      size_t done = num_thread_trees * (b + 1) / num_blocks;
+      if (done > reported) {
+        std::unique_lock<std::mutex> lock(mutex);
+        progress += done - reported;
+        reported = done;
+        condition_variable.notify_one();
+      }
+    }
+
+    if (reported < num_thread_trees) {
+      std::unique_lock<std::mutex> lock(mutex);
+      progress += num_thread_trees - reported;
+      condition_variable.notify_one();
+    }
+  }
+}
+
 void Forest::predictInternalInThread(uint thread_idx) {
   // Create thread ranges
   std::vector<uint> predict_ranges;
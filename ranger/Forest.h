@@ -79,6 +79,11 @@ public:
   // Grow or predict
   void run(bool verbose, bool compute_oob_error);
 
+  // Find ordered splits on data pre-binned into at most max_bins bins per variable when growing, 0 for exact splits
+  void setHistogramBins(uint max_bins) {
+    histogram_bins = max_bins;
+  }
+
   // Write results to output files
   void writeOutput();
   virtual void writeOutputInternal() = 0;
@@ -196,6 +201,7 @@ protected:
   // Multithreading methods for growing/prediction/importance, called by each thread
   void growTreesInThread(uint thread_idx, std::vector<double>* variable_importance);
   void predictTreesInThread(uint thread_idx, const Data* prediction_data, bool oob_prediction);
+  void predictTreeBlocksInThread(uint thread_idx, const Data* prediction_data);
   void predictInternalInThread(uint thread_idx);
   void computeTreePermutationImportanceInThread(uint thread_idx, std::vector<double>& importance,
       std::vector<double>& variance, std::vector<double>& importance_casewise);
@@ -292,6 +298,7 @@ protected:
 #endif
 
   int percent {0};
+  uint histogram_bins {0};
 };
 
 } // namespace ranger
@@ -0,0 +1,89 @@
+/*-------------------------------------------------------------------------------
+ This file is part of ranger.
+
+ Copyright (c) [2014-2018] [Marvin N. Wright]
+
+ This software may be modified and distributed under the terms of the MIT license.
+
+ Please note that the C++ core of ranger is distributed under MIT license and the
+ R package "ranger" under GPL3 license.
+ #-------------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "ForestModel.h"
+
+namespace ranger {
+
+ForestModel::ForestModel(const char* buffer, size_t size) {
+
+  if (buffer == nullptr || size < sizeof(ForestModelHeader) || reinterpret_cast<uintptr_t>(buffer) % 8 != 0) {
+    throw std::runtime_error("Not a forest model.");
+  }
+  header = reinterpret_cast<const ForestModelHeader*>(buffer);
+  if (std::memcmp(header->magic, FOREST_MODEL_MAGIC, sizeof(FOREST_MODEL_MAGIC)) != 0) {
+    throw std::runtime_error("Not a forest model.");
+  }
+  if (header->version != FOREST_MODEL_VERSION) {
+    throw std::runtime_error("Unsupported forest model version " + std::to_string(header->version) + ".");
+  }
+
+  // Check sizes before pointing into the buffer
+  size_t expected_size = sizeof(ForestModelHeader) + header->num_classes * sizeof(double)
+      + (header->num_trees + 1) * sizeof(uint64_t) + header->num_nodes * sizeof(Tree::PackedNode)
+      + header->num_leaves * header->num_classes * sizeof(double);
+  if (header->num_trees == 0 || size != expected_size) {
+    throw std::runtime_error("Forest model is truncated or corrupt.");
+  }
+
+  const char* pos = buffer + sizeof(ForestModelHeader);
+  class_values = reinterpret_cast<const double*>(pos);
+  pos += header->num_classes * sizeof(double);
+  tree_offsets = reinterpret_cast<const uint64_t*>(pos);
+  pos += (header->num_trees + 1) * sizeof(uint64_t);
+  nodes = reinterpret_cast<const Tree::PackedNode*>(pos);
+  pos += header->num_nodes * sizeof(Tree::PackedNode);
+  leaf_values = reinterpret_cast<const double*>(pos);
+
+  // Check every node stays within its tree and the leaves, so prediction cannot run off the buffer
+  for (size_t tree_idx = 0; tree_idx < header->num_trees; ++tree_idx) {
+    uint64_t begin = tree_offsets[tree_idx];
+    uint64_t end = tree_offsets[tree_idx + 1];
+    if (begin >= end || end > header->num_nodes) {
+      throw std::runtime_error("Forest model is truncated or corrupt.");
+    }
+    for (uint64_t i = begin; i < end; ++i) {
+      bool terminal = nodes[i].right == 0;
+      if ((terminal && nodes[i].varID >= header->num_leaves)
+          || (!terminal && (nodes[i].varID >= header->num_variables || nodes[i].right <= i - begin + 1
+              || nodes[i].right >= end - begin || i + 1 >= end))) {
+        throw std::runtime_error("Forest model is truncated or corrupt.");
+      }
+    }
+  }
+}
+
+void ForestModel::predict(const double* sample, double* probabilities) const {
+  size_t num_classes = header->num_classes;
+  std::fill_n(probabilities, num_classes, 0);
+
+  for (size_t tree_idx = 0; tree_idx < header->num_trees; ++tree_idx) {
+    const Tree::PackedNode* tree = nodes + tree_offsets[tree_idx];
+    size_t packedID = 0;
+    while (tree[packedID].right != 0) {
+      packedID = sample[tree[packedID].varID] <= tree[packedID].split_value ? packedID + 1 : tree[packedID].right;
+    }
+    const double* leaf = leaf_values + tree[packedID].varID * num_classes;
+    for (size_t class_idx = 0; class_idx < num_classes; ++class_idx) {
+      probabilities[class_idx] += leaf[class_idx];
+    }
+  }
+
+  for (size_t class_idx = 0; class_idx < num_classes; ++class_idx) {
+    probabilities[class_idx] /= header->num_trees;
+  }
+}
+
+} // namespace ranger
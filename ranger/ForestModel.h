@@ -0,0 +1,76 @@
+/*-------------------------------------------------------------------------------
+ This file is part of ranger.
+
+ Copyright (c) [2014-2018] [Marvin N. Wright]
+
+ This software may be modified and distributed under the terms of the MIT license.
+
+ Please note that the C++ core of ranger is distributed under MIT license and the
+ R package "ranger" under GPL3 license.
+ #-------------------------------------------------------------------------------*/
+
+#ifndef FORESTMODEL_H_
+#define FORESTMODEL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "globals.h"
+#include "Tree.h"
+
+namespace ranger {
+
+// Versioned binary probability forest, written by ForestProbability::saveModel(). All sections are 8 byte aligned
+// so a memory mapped file can be predicted from in place:
+//   ForestModelHeader
+//   double class_values[num_classes]
+//   uint64_t tree_offsets[num_trees + 1], first packed node of each tree
+//   Tree::PackedNode nodes[num_nodes], terminal nodes hold their leaf index in varID
+//   double leaf_values[num_leaves * num_classes], class fractions per leaf
+struct ForestModelHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_variables;
+  uint64_t num_trees;
+  uint64_t num_classes;
+  uint64_t num_nodes;
+  uint64_t num_leaves;
+};
+
+static_assert(sizeof(ForestModelHeader) == 48 && sizeof(Tree::PackedNode) == 16, "Forest model layout changed");
+
+const char FOREST_MODEL_MAGIC[8] = { 'R', 'N', 'G', 'R', 'P', 'R', 'O', 'B' };
+const uint32_t FOREST_MODEL_VERSION = 1;
+
+class ForestModel {
+public:
+  // View on a model in memory, which must stay valid and 8 byte aligned. Throws if the buffer is not a valid model
+  ForestModel(const char* buffer, size_t size);
+
+  size_t getNumVariables() const {
+    return header->num_variables;
+  }
+  size_t getNumTrees() const {
+    return header->num_trees;
+  }
+  size_t getNumClasses() const {
+    return header->num_classes;
+  }
+  const double* getClassValues() const {
+    return class_values;
+  }
+
+  // Class probabilities averaged over trees for one sample with getNumVariables() values
+  void predict(const double* sample, double* probabilities) const;
+
+private:
+  const ForestModelHeader* header;
+  const double* class_values;
+  const uint64_t* tree_offsets;
+  const Tree::PackedNode* nodes;
+  const double* leaf_values;
+};
+
+} // namespace ranger
+
+#endif /* FORESTMODEL_H_ */
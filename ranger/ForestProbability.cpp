@@ -13,6 +13,7 @@
 
 #include "utility.h"
 #include "ForestProbability.h"
+#include "ForestModel.h"
 #include "TreeProbability.h"
 #include "Data.h"
 
@@ -81,6 +82,22 @@ void ForestProbability::initInternal() {
       response_classIDs.push_back(classID);
     }
 
+    // Same for each imputation, sharing class_values
+    imputed_response_classIDs.resize(imputed_responses.size());
+    for (size_t m = 0; m < imputed_responses.size(); ++m) {
+      if (imputed_responses[m].size() != num_samples) {
+        throw std::runtime_error("Number of imputed responses does not match number of samples.");
+      }
+      imputed_response_classIDs[m].reserve(num_samples);
+      for (auto value : imputed_responses[m]) {
+        uint classID = find(class_values.begin(), class_values.end(), value) - class_values.begin();
+        if (classID == class_values.size()) {
+          class_values.push_back(value);
+        }
+        imputed_response_classIDs[m].push_back(classID);
+      }
+    }
+
     if (splitrule == HELLINGER && class_values.size() != 2) {
       throw std::runtime_error("Hellinger splitrule only implemented for binary classification.");
     }
@@ -96,6 +113,13 @@ void ForestProbability::initInternal() {
       size_t classID = response_classIDs[i];
       sampleIDs_per_class[classID].push_back(i);
     }
+    imputed_sampleIDs_per_class.resize(imputed_response_classIDs.size(),
+        std::vector<std::vector<size_t>>(sample_fraction.size()));
+    for (size_t m = 0; m < imputed_response_classIDs.size(); ++m) {
+      for (size_t i = 0; i < num_samples; ++i) {
+        imputed_sampleIDs_per_class[m][imputed_response_classIDs[m][i]].push_back(i);
+      }
+    }
   }
 
   // Set class weights all to 1
@@ -110,8 +134,15 @@ void ForestProbability::initInternal() {
 void ForestProbability::growInternal() {
   trees.reserve(num_trees);
   for (size_t i = 0; i < num_trees; ++i) {
-    trees.push_back(
-        std::make_unique<TreeProbability>(&class_values, &response_classIDs, &sampleIDs_per_class, &class_weights));
+    if (imputed_response_classIDs.empty()) {
+      trees.push_back(
+          std::make_unique<TreeProbability>(&class_values, &response_classIDs, &sampleIDs_per_class, &class_weights));
+    } else {
+      size_t m = i % imputed_response_classIDs.size();
+      trees.push_back(
+          std::make_unique<TreeProbability>(&class_values, &imputed_response_classIDs[m],
+              &imputed_sampleIDs_per_class[m], &class_weights));
+    }
   }
 }
 
@@ -331,6 +362,56 @@ void ForestProbability::loadFromFileInternal(std::ifstream& infile) {
   }
 }
 
+void ForestProbability::saveModel(const std::string& filename) {
+
+  // Pack trees, terminal nodes get consecutive leaf indices
+  size_t num_classes = class_values.size();
+  std::vector<uint64_t> tree_offsets { 0 };
+  std::vector<Tree::PackedNode> nodes;
+  std::vector<double> leaf_values;
+  for (auto& tree : trees) {
+    if (!tree->pack(data.get())) {
+      throw std::runtime_error("Forest models only support ordered variables.");
+    }
+    const auto& terminal_class_counts = dynamic_cast<const TreeProbability&>(*tree).getTerminalClassCounts();
+    for (auto node : tree->getPackedNodes()) {
+      if (node.right == 0) {
+        const auto& counts = terminal_class_counts[node.varID];
+        node.varID = leaf_values.size() / num_classes;
+        leaf_values.insert(leaf_values.end(), counts.begin(), counts.end());
+        leaf_values.resize((node.varID + 1) * num_classes, 0);
+      }
+      nodes.push_back(node);
+    }
+    tree_offsets.push_back(nodes.size());
+  }
+
+  ForestModelHeader header;
+  std::copy_n(FOREST_MODEL_MAGIC, sizeof(header.magic), header.magic);
+  header.version = FOREST_MODEL_VERSION;
+  header.num_variables = num_independent_variables;
+  header.num_trees = trees.size();
+  header.num_classes = num_classes;
+  header.num_nodes = nodes.size();
+  header.num_leaves = leaf_values.size() / num_classes;
+
+  std::ofstream outfile;
+  outfile.open(filename, std::ios::binary);
+  if (!outfile.good()) {
+    throw std::runtime_error("Could not write to model file: " + filename + ".");
+  }
+  outfile.write((char*) &header, sizeof(header));
+  outfile.write((char*) class_values.data(), class_values.size() * sizeof(double));
+  outfile.write((char*) tree_offsets.data(), tree_offsets.size() * sizeof(uint64_t));
+  outfile.write((char*) nodes.data(), nodes.size() * sizeof(Tree::PackedNode));
+  outfile.write((char*) leaf_values.data(), leaf_values.size() * sizeof(double));
+  if (!outfile.good()) {
+    throw std::runtime_error("Could not write to model file: " + filename + ".");
+  }
+  if (verbose_out)
+    *verbose_out << "Saved forest model to file " << filename << "." << std::endl;
+}
+
 const std::vector<double>& ForestProbability::getTreePrediction(size_t tree_idx, size_t sample_idx) const {
   const auto& tree = dynamic_cast<const TreeProbability&>(*trees[tree_idx]);
   return tree.getPrediction(sample_idx);
@@ -46,6 +46,15 @@ public:
     this->class_weights = class_weights;
   }
 
+  // Save in the versioned binary model format, see ForestModel.h
+  void saveModel(const std::string& filename);
+
+  // Multiple imputation: one response vector per imputation, set before init. Trees are assigned to imputations round
+  // robin, so all imputations are grown in a single forest and averaged at prediction.
+  void setImputedResponses(const std::vector<std::vector<double>>& imputed_responses) {
+    this->imputed_responses = imputed_responses;
+  }
+
 protected:
   void initInternal() override;
   void growInternal() override;
@@ -63,6 +72,11 @@ protected:
   std::vector<uint> response_classIDs;
   std::vector<std::vector<size_t>> sampleIDs_per_class;
 
+  // Responses, classIDs and sampleIDs_per_class for each imputation
+  std::vector<std::vector<double>> imputed_responses;
+  std::vector<std::vector<uint>> imputed_response_classIDs;
+  std::vector<std::vector<std::vector<size_t>>> imputed_sampleIDs_per_class;
+
   // Splitting weights
   std::vector<double> class_weights;
 
@@ -144,6 +144,8 @@ void Tree::grow(std::vector<double>* variable_importance) {
   // Delete sampleID vector to save memory
   sampleIDs.clear();
   sampleIDs.shrink_to_fit();
+  node_histograms.clear();
+  node_histograms.shrink_to_fit();
   cleanUpInternal();
 }
 
@@ -205,6 +207,49 @@ void Tree::predict(const Data* prediction_data, bool oob_prediction) {
   }
 }
 
+bool Tree::pack(const Data* prediction_data) {
+
+  packed_nodes.clear();
+  packed_nodes.reserve(split_varIDs.size());
+
+  // Depth first from the root, a right child patches its offset into the parent once its position is known
+  const size_t no_parent = -1;
+  std::vector<std::pair<size_t, size_t>> stack;
+  stack.emplace_back(0, no_parent);
+  while (!stack.empty()) {
+    auto [nodeID, parent] = stack.back();
+    stack.pop_back();
+    if (parent != no_parent) {
+      packed_nodes[parent].right = packed_nodes.size();
+    }
+
+    if (child_nodeIDs[0][nodeID] == 0 && child_nodeIDs[1][nodeID] == 0) {
+      packed_nodes.push_back( { 0, (uint32_t) nodeID, 0 });
+    } else {
+      if (!prediction_data->isOrderedVariable(split_varIDs[nodeID])) {
+        packed_nodes.clear();
+        return false;
+      }
+      stack.emplace_back(child_nodeIDs[1][nodeID], packed_nodes.size());
+      stack.emplace_back(child_nodeIDs[0][nodeID], no_parent);
+      packed_nodes.push_back( { split_values[nodeID], (uint32_t) split_varIDs[nodeID], 0 });
+    }
+  }
+  return true;
+}
+
+void Tree::predictBlock(const double* block, size_t num_cols, size_t begin, size_t end) {
+  const PackedNode* nodes = packed_nodes.data();
+  for (size_t i = begin; i < end; ++i) {
+    const double* row = block + (i - begin) * num_cols;
+    size_t packedID = 0;
+    while (nodes[packedID].right != 0) {
+      packedID = row[nodes[packedID].varID] <= nodes[packedID].split_value ? packedID + 1 : nodes[packedID].right;
+    }
+    prediction_terminal_nodeIDs[i] = nodes[packedID].varID;
+  }
+}
+
 void Tree::computePermutationImportance(std::vector<double>& forest_importance, std::vector<double>& forest_variance,
     std::vector<double>& forest_importance_casewise) {
 
@@ -316,6 +361,9 @@ bool Tree::splitNode(size_t nodeID) {
   bool stop = splitNodeInternal(nodeID, possible_split_varIDs);
   if (stop) {
     // Terminal node
+    if (nodeID < node_histograms.size()) {
+      std::vector<size_t>().swap(node_histograms[nodeID]);
+    }
     return true;
   }
 
@@ -376,10 +424,154 @@ bool Tree::splitNode(size_t nodeID) {
   end_pos[left_child_nodeID] = start_pos[right_child_nodeID];
   end_pos[right_child_nodeID] = end_pos[nodeID];
 
+  if (histogram_splitting) {
+    deriveChildHistograms(nodeID, left_child_nodeID, right_child_nodeID);
+  }
+
   // No terminal node
   return false;
 }
 
+const std::vector<size_t>& Tree::nodeHistogram(size_t nodeID) {
+  if (nodeID >= node_histograms.size()) {
+    node_histograms.resize(split_varIDs.size());
+  }
+  if (node_histograms[nodeID].empty()) {
+    computeNodeHistogram(nodeID, node_histograms[nodeID]);
+  }
+  return node_histograms[nodeID];
+}
+
+void Tree::computeNodeHistogram(size_t nodeID, std::vector<size_t>& histogram) const {
+  size_t num_cols = data->getNumBinnedCols();
+  size_t num_bins = data->getMaxNumBins();
+  histogram.assign(num_cols * num_bins * histogram_num_classes, 0);
+  for (size_t pos = start_pos[nodeID]; pos < end_pos[nodeID]; ++pos) {
+    size_t sampleID = sampleIDs[pos];
+    size_t classID = (*histogram_classIDs)[sampleID];
+    for (size_t varID = 0; varID < num_cols; ++varID) {
+      ++histogram[(varID * num_bins + data->getBin(sampleID, varID)) * histogram_num_classes + classID];
+    }
+  }
+}
+
+void Tree::deriveChildHistograms(size_t nodeID, size_t left_child_nodeID, size_t right_child_nodeID) {
+  node_histograms.resize(split_varIDs.size());
+
+  // Count the smaller child, the larger one is the parent minus the smaller
+  if (!node_histograms[nodeID].empty() && end_pos[nodeID] - start_pos[nodeID] >= HISTOGRAM_SUBTRACTION_MIN_NODE_SIZE) {
+    size_t n_left = end_pos[left_child_nodeID] - start_pos[left_child_nodeID];
+    size_t n_right = end_pos[right_child_nodeID] - start_pos[right_child_nodeID];
+    size_t smaller_nodeID = n_left < n_right ? left_child_nodeID : right_child_nodeID;
+    size_t larger_nodeID = n_left < n_right ? right_child_nodeID : left_child_nodeID;
+
+    computeNodeHistogram(smaller_nodeID, node_histograms[smaller_nodeID]);
+    node_histograms[larger_nodeID] = std::move(node_histograms[nodeID]);
+    std::vector<size_t>& larger = node_histograms[larger_nodeID];
+    const std::vector<size_t>& smaller = node_histograms[smaller_nodeID];
+    for (size_t i = 0; i < larger.size(); ++i) {
+      larger[i] -= smaller[i];
+    }
+  }
+  std::vector<size_t>().swap(node_histograms[nodeID]);
+}
+
+void Tree::findBestSplitValueHistogram(size_t nodeID, size_t varID, size_t num_classes,
+    const std::vector<size_t>& class_counts, size_t num_samples_node, double& best_value, size_t& best_varID,
+    double& best_decrease, const std::vector<double>& class_weights, std::vector<size_t>& counter) {
+
+  // Class counts per bin of this variable, from the node histogram
+  size_t num_bins = data->getNumBins(varID);
+  const size_t* counter_per_bin = nodeHistogram(nodeID).data() + varID * data->getMaxNumBins() * num_classes;
+  std::fill_n(counter.begin(), num_bins, 0);
+  for (size_t i = 0; i < num_bins; ++i) {
+    for (size_t j = 0; j < num_classes; ++j) {
+      counter[i] += counter_per_bin[i * num_classes + j];
+    }
+  }
+
+  size_t n_left = 0;
+  std::vector<size_t> class_counts_left(num_classes);
+
+  // Compute decrease of impurity for each split between bins
+  for (size_t i = 0; i < num_bins - 1; ++i) {
+
+    // Stop if nothing here
+    if (counter[i] == 0) {
+      continue;
+    }
+
+    n_left += counter[i];
+
+    // Stop if right child empty
+    size_t n_right = num_samples_node - n_left;
+    if (n_right == 0) {
+      break;
+    }
+
+    // Stop if minimal bucket size reached
+    if (n_left < min_bucket || n_right < min_bucket) {
+      for (size_t j = 0; j < num_classes; ++j) {
+        class_counts_left[j] += counter_per_bin[i * num_classes + j];
+      }
+      continue;
+    }
+
+    double decrease;
+    if (splitrule == HELLINGER) {
+      for (size_t j = 0; j < num_classes; ++j) {
+        class_counts_left[j] += counter_per_bin[i * num_classes + j];
+      }
+
+      // TPR is number of outcome 1s in one node / total number of 1s
+      // FPR is number of outcome 0s in one node / total number of 0s
+      double tpr = (double) (class_counts[1] - class_counts_left[1]) / (double) class_counts[1];
+      double fpr = (double) (class_counts[0] - class_counts_left[0]) / (double) class_counts[0];
+
+      // Decrease of impurity
+      double a1 = sqrt(tpr) - sqrt(fpr);
+      double a2 = sqrt(1 - tpr) - sqrt(1 - fpr);
+      decrease = sqrt(a1 * a1 + a2 * a2);
+    } else {
+      // Sum of squares
+      double sum_left = 0;
+      double sum_right = 0;
+      for (size_t j = 0; j < num_classes; ++j) {
+        class_counts_left[j] += counter_per_bin[i * num_classes + j];
+        size_t class_count_right = class_counts[j] - class_counts_left[j];
+
+        sum_left += class_weights[j] * class_counts_left[j] * class_counts_left[j];
+        sum_right += class_weights[j] * class_count_right * class_count_right;
+      }
+
+      // Decrease of impurity
+      decrease = sum_right / (double) n_right + sum_left / (double) n_left;
+    }
+
+    // Regularization
+    regularize(decrease, varID);
+
+    // If better than before, use this
+    if (decrease > best_decrease) {
+      // Find next bin in this node
+      size_t j = i + 1;
+      while (j < num_bins && counter[j] == 0) {
+        ++j;
+      }
+
+      // Use mid-point between the bins
+      best_value = (data->getBinUpperValue(varID, i) + data->getBinLowerValue(varID, j)) / 2;
+      best_varID = varID;
+      best_decrease = decrease;
+
+      // Use smaller value if average is numerically the same as the larger value
+      if (best_value == data->getBinLowerValue(varID, j)) {
+        best_value = data->getBinUpperValue(varID, i);
+      }
+    }
+  }
+}
+
 void Tree::createEmptyNode() {
   split_varIDs.push_back(0);
   split_values.push_back(0);
@@ -13,6 +13,7 @@
 #define TREE_H_
 
 #include <vector>
+#include <cstdint>
 #include <random>
 #include <iostream>
 #include <stdexcept>
@@ -24,6 +25,14 @@ namespace ranger {
 
 class Tree {
 public:
+  // Node layout for prediction, in preorder so the left child always follows its parent.
+  // right is the packed index of the right child, 0 for terminal nodes where varID holds the original nodeID
+  struct PackedNode {
+    double split_value;
+    uint32_t varID;
+    uint32_t right;
+  };
+
   Tree();
 
   // Create from loaded forest
@@ -45,10 +54,27 @@ public:
 
   virtual void allocateMemory() = 0;
 
+  // Find ordered splits on the pre-binned data (Data::binData()) instead of all unique values
+  void setHistogramSplitting(bool histogram_splitting) {
+    this->histogram_splitting = histogram_splitting;
+  }
+
   void grow(std::vector<double>* variable_importance);
 
   void predict(const Data* prediction_data, bool oob_prediction);
 
+  // Compile the tree into packed_nodes for block prediction, false if it splits on unordered variables
+  bool pack(const Data* prediction_data);
+
+  // Predict rows [begin, end) from a row-major block of their features, requires pack()
+  void predictBlock(const double* block, size_t num_cols, size_t begin, size_t end);
+  const std::vector<PackedNode>& getPackedNodes() const {
+    return packed_nodes;
+  }
+  void allocatePredictionMemory(size_t num_samples_predict) {
+    prediction_terminal_nodeIDs.assign(num_samples_predict, 0);
+  }
+
   void computePermutationImportance(std::vector<double>& forest_importance, std::vector<double>& forest_variance,
       std::vector<double>& forest_importance_casewise);
 
@@ -113,6 +139,17 @@ protected:
 
   virtual void cleanUpInternal() = 0;
 
+  // Class counts per variable and bin for the samples in a node, layout [varID][bin][classID]
+  const std::vector<size_t>& nodeHistogram(size_t nodeID);
+  void computeNodeHistogram(size_t nodeID, std::vector<size_t>& histogram) const;
+  void deriveChildHistograms(size_t nodeID, size_t left_child_nodeID, size_t right_child_nodeID);
+
+  // Best split between the bins of an ordered variable from the node histogram, shared by the classification and
+  // probability trees
+  void findBestSplitValueHistogram(size_t nodeID, size_t varID, size_t num_classes,
+      const std::vector<size_t>& class_counts, size_t num_samples_node, double& best_value, size_t& best_varID,
+      double& best_decrease, const std::vector<double>& class_weights, std::vector<size_t>& counter);
+
   void regularize(double& decrease, size_t varID) {
     if (regularization) {
       if (importance_mode == IMP_GINI_CORRECTED) {
@@ -192,6 +229,16 @@ protected:
   // Vector of left and right child node IDs, 0 for no child
   std::vector<std::vector<size_t>> child_nodeIDs;
 
+  // Packed copy of the nodes for prediction
+  std::vector<PackedNode> packed_nodes;
+
+  // Histogram splitting, classIDs and number of classes are set by the subclass. Histograms are kept per open node
+  // so that large children can be derived from their parent by subtraction
+  bool histogram_splitting = false;
+  const std::vector<uint>* histogram_classIDs = nullptr;
+  size_t histogram_num_classes = 0;
+  std::vector<std::vector<size_t>> node_histograms;
+
   // All sampleIDs in the tree, will be re-ordered while splitting
   std::vector<size_t> sampleIDs;
 
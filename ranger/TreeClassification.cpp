@@ -48,6 +48,9 @@ void TreeClassification::allocateMemory() {
     counter.resize(max_num_splits);
     counter_per_class.resize(num_classes * max_num_splits);
   }
+
+  histogram_classIDs = response_classIDs;
+  histogram_num_classes = class_values->size();
 }
 
 double TreeClassification::estimate(size_t nodeID) {
@@ -179,6 +182,9 @@ bool TreeClassification::findBestSplit(size_t nodeID, std::vector<size_t>& possi
         if (memory_saving_splitting) {
           findBestSplitValueSmallQ(nodeID, varID, num_classes, class_counts, num_samples_node, best_value, best_varID,
               best_decrease);
+        } else if (histogram_splitting) {
+          findBestSplitValueHistogram(nodeID, varID, num_classes, class_counts, num_samples_node, best_value,
+              best_varID, best_decrease, *class_weights, counter);
         } else {
           // Use faster method for both cases
           double q = (double) num_samples_node / (double) data->getNumUniqueDataValues(varID);
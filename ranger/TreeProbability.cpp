@@ -42,6 +42,9 @@ void TreeProbability::allocateMemory() {
     counter.resize(max_num_splits);
     counter_per_class.resize(num_classes * max_num_splits);
   }
+
+  histogram_classIDs = response_classIDs;
+  histogram_num_classes = class_values->size();
 }
 
 void TreeProbability::addToTerminalNodes(size_t nodeID) {
@@ -98,10 +101,10 @@ bool TreeProbability::splitNodeInternal(size_t nodeID, std::vector<size_t>& poss
 
   // Check if node is pure and set split_value to estimate and stop if pure
   bool pure = true;
-  double pure_value = 0;
+  uint pure_value = 0;
   for (size_t pos = start_pos[nodeID]; pos < end_pos[nodeID]; ++pos) {
     size_t sampleID = sampleIDs[pos];
-    double value = data->get_y(sampleID, 0);
+    uint value = (*response_classIDs)[sampleID];
     if (pos != start_pos[nodeID] && value != pure_value) {
       pure = false;
       break;
@@ -183,6 +186,9 @@ bool TreeProbability::findBestSplit(size_t nodeID, std::vector<size_t>& possible
         if (memory_saving_splitting) {
           findBestSplitValueSmallQ(nodeID, varID, num_classes, class_counts, num_samples_node, best_value, best_varID,
               best_decrease);
+        } else if (histogram_splitting) {
+          findBestSplitValueHistogram(nodeID, varID, num_classes, class_counts, num_samples_node, best_value,
+              best_varID, best_decrease, *class_weights, counter);
         } else {
           // Use faster method for both cases
           double q = (double) num_samples_node / (double) data->getNumUniqueDataValues(varID);
@@ -96,6 +96,12 @@ const double DEFAULT_SAMPLE_FRACTION_NOREPLACE = 0.632;
 const double STATUS_INTERVAL = 30;
 // Threshold for q value split method switch
 const double Q_THRESHOLD = 0.02;
+// Number of bins per variable for histogram splitting
+const uint DEFAULT_HISTOGRAM_BINS = 255;
+// Minimal node size to derive child histograms from the parent by subtraction
+const uint HISTOGRAM_SUBTRACTION_MIN_NODE_SIZE = 2048;
+// Number of samples predicted together by all trees of a thread
+const uint PREDICTION_BLOCK_SIZE = 256;
 
 } // namespace ranger
 